@@ -0,0 +1,380 @@
+// Microbenchmark suite: times the simulation and loading hot paths one at
+// a time, at ball counts from 10 to 1M, and optionally writes the results
+// as JSON for bench/compare.py.
+//
+//   ballquest_bench [--filter TEXT] [--max N] [--threads N] [--min-time S]
+//                   [--bitmap FILE] [--json FILE]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/Collision.h"
+#include "../include/FruitPool.h"
+#include "../include/Frustum.h"
+#include "../include/JobSystem.h"
+#include "../include/Profiler.h"
+#include "../include/Texture.h"
+#include "../include/sphere.h"
+
+using namespace std;
+
+#ifndef BALLQUEST_BUILD_TYPE
+#define BALLQUEST_BUILD_TYPE "unknown"
+#endif
+#ifndef BALLQUEST_SOURCE_DIR
+#define BALLQUEST_SOURCE_DIR "."
+#endif
+
+// Average balls per square unit of floor, as in GridBench
+const float BALL_DENSITY = 0.25f;
+// Update benchmarks start this high so nothing lands while they run
+const float START_HEIGHT = 1.0e6f;
+const float STEP         = 1.0f / 120.0f;
+const int   SAMPLES      = 7;
+
+// Everything a benchmark may touch; each one sets up what it needs
+struct Fixture {
+    FruitPool       fruits;
+    Random          random;
+    JobSystem*      jobs;
+    int             count;
+    int             half;
+    vector<int>     candidates;
+    vector<int>     hits;
+    vector<Vector3> vectors;
+    vector<float>        vertices;
+    vector<unsigned int> indices;
+    string          bitmapPath;
+    size_t          checksum;   // Keeps results alive past the optimizer
+
+    Fixture() : fruits(FruitType::MAIN), random(1), jobs(nullptr), count(0), half(0), checksum(0) {}
+};
+
+typedef void (*SetupFunc)(Fixture& fixture, int count);
+typedef void (*RunFunc)(Fixture& fixture, int iteration);
+
+struct Benchmark {
+    const char* name;
+    bool        scales;   // Run at every ball count, otherwise once
+    SetupFunc   setup;
+    RunFunc     run;
+};
+
+struct Result {
+    string name;
+    int    count;
+    int    iterations;   // Per sample
+    double medianNs;     // Per iteration
+    double minNs;
+};
+
+// Balls spread over an arena that grows with the count, so density and
+// hits per query stay about the same at every size
+static void SetupPool(Fixture& f, int count, float height, float spacing) {
+    f.count = count;
+    f.half = max(1, static_cast<int>(std::sqrt(count / BALL_DENSITY) / 2.0f));
+    f.fruits.SetSpawnArea(f.half, f.half);
+    f.random = Random(1);
+    f.fruits.Reset(count, height, spacing, f.random, f.jobs);
+}
+
+static CatchVolume VolumeAt(const Fixture& f, int iteration) {
+    float angle = iteration * 0.05f;
+    Vector3 position(std::cos(angle) * f.half * 0.5f, 2.0f, std::sin(angle) * f.half * 0.5f);
+    Vector3 view = position + Vector3(-std::sin(angle), -0.3f, std::cos(angle));
+    return MakeCatchVolume(position, view);
+}
+
+// FruitPool::Update: one simulation step for every ball
+static void SetupUpdate(Fixture& f, int count) {
+    SetupPool(f, count, START_HEIGHT, 0.0f);
+}
+
+static void RunUpdate(Fixture& f, int) {
+    f.fruits.Update(STEP, 1.0f, f.jobs);
+}
+
+// FruitPool::Refill: an eighth of the balls land and respawn per step,
+// including the loop that grounds them
+static void SetupRespawn(Fixture& f, int count) {
+    SetupPool(f, count, START_HEIGHT, 0.0f);
+}
+
+static void RunRespawn(Fixture& f, int iteration) {
+    for (int i = iteration & 7; i < f.fruits.Size(); i += 8) {
+        f.fruits.SetActive(i, false);
+    }
+    f.fruits.Refill(f.count, START_HEIGHT, 0.0f, f.random, f.jobs);
+}
+
+// Catch tests around a player circling the arena, through the grid and by
+// scanning every ball. Balls are stacked through the catch height.
+static void SetupCatch(Fixture& f, int count) {
+    SetupPool(f, count, 0.0f, 50.0f / count);
+    f.fruits.Update(STEP, 1.0f, f.jobs);
+}
+
+static void RunQuery(Fixture& f, int iteration) {
+    f.hits.clear();
+    QueryCatches(f.fruits, VolumeAt(f, iteration), f.candidates, f.hits, f.jobs);
+    f.checksum += f.hits.size();
+}
+
+static void RunScan(Fixture& f, int iteration) {
+    f.hits.clear();
+    FindCatches(f.fruits, VolumeAt(f, iteration), f.hits);
+    f.checksum += f.hits.size();
+}
+
+// The game's view from a player circling the arena: gluPerspective(45,
+// 4:3, 0.1, 1000) times gluLookAt, both column-major
+static Frustum FrustumAt(const Fixture& f, int iteration) {
+    float angle = iteration * 0.05f;
+    Vector3 eye(std::cos(angle) * f.half * 0.5f, 2.0f, std::sin(angle) * f.half * 0.5f);
+    Vector3 forward(-std::sin(angle), 0.3f, std::cos(angle));
+    forward.Normalize();
+    Vector3 side = forward.Cross(Vector3(0.0f, 1.0f, 0.0f));
+    side.Normalize();
+    Vector3 up = side.Cross(forward);
+
+    const float nearZ = 0.1f, farZ = 1000.0f;
+    const float focal = 1.0f / std::tan(22.5f * 3.14159265f / 180.0f);
+    const float projection[16] = {
+        focal / (4.0f / 3.0f), 0.0f, 0.0f, 0.0f,
+        0.0f, focal, 0.0f, 0.0f,
+        0.0f, 0.0f, (farZ + nearZ) / (nearZ - farZ), -1.0f,
+        0.0f, 0.0f, 2.0f * farZ * nearZ / (nearZ - farZ), 0.0f
+    };
+    const float view[16] = {
+        side.x, up.x, -forward.x, 0.0f,
+        side.y, up.y, -forward.y, 0.0f,
+        side.z, up.z, -forward.z, 0.0f,
+        -side.Dot(eye), -up.Dot(eye), forward.Dot(eye), 1.0f
+    };
+
+    Frustum frustum;
+    frustum.Extract(projection, view);
+    return frustum;
+}
+
+// FruitPool::Cull: every ball against the view frustum, from the catch
+// setup so some are above and behind the camera
+static void RunCull(Fixture& f, int iteration) {
+    f.fruits.Cull(FrustumAt(f, iteration), 0.5f);
+    f.checksum += f.fruits.Visible().size();
+}
+
+// Vector3::Normalize over an array of unnormalized vectors
+static void SetupNormalize(Fixture& f, int count) {
+    f.random = Random(1);
+    f.vectors.resize(count);
+    for (Vector3& v : f.vectors) {
+        v = Vector3(Random::Below(f.random.Next(), 20000) * 0.01f - 100.0f,
+                    Random::Below(f.random.Next(), 20000) * 0.01f - 100.0f,
+                    Random::Below(f.random.Next(), 20000) * 0.01f - 100.0f);
+    }
+}
+
+static void RunNormalize(Fixture& f, int iteration) {
+    // Alternate scales so every pass does real work
+    float scale = (iteration & 1) ? 0.5f : 2.0f;
+    for (Vector3& v : f.vectors) {
+        v = v * scale;
+        v.Normalize();
+    }
+    // x is in [-1, 1]; shifted so the sum never wraps
+    f.checksum += static_cast<size_t>(static_cast<int>((f.vectors[0].x + 1.0f) * 1000.0f));
+}
+
+// The CPU side of LoadBitmap: map the file, parse it and read every pixel
+// row once, as the driver does when it copies the upload
+static void SetupBitmap(Fixture&, int) {}
+
+static void RunBitmap(Fixture& f, int) {
+    int fd = open(f.bitmapPath.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    TextureImage image;
+    if (ParseBitmap(f.bitmapPath.c_str(), bytes, size, image)) {
+        const unsigned char* pixels = bytes + image.payloadOffset;
+        size_t sum = 0;
+        for (size_t i = 0; i < image.payloadSize; i += 64) {
+            sum += pixels[i];
+        }
+        f.checksum += sum;
+    }
+    munmap(data, size);
+}
+
+// Sphere mesh generation at the instanced ball and gluSphere resolutions
+static void SetupSphere(Fixture& f, int) {
+    f.vertices.clear();
+    f.indices.clear();
+}
+
+static void RunSphereSmall(Fixture& f, int) {
+    f.vertices.clear();
+    f.indices.clear();
+    Sphere::generateMesh(1.0f, 12, 8, f.vertices, f.indices);
+    f.checksum += f.indices.size();
+}
+
+static void RunSphereLarge(Fixture& f, int) {
+    f.vertices.clear();
+    f.indices.clear();
+    Sphere::generateMesh(1.0f, 32, 32, f.vertices, f.indices);
+    f.checksum += f.indices.size();
+}
+
+static const Benchmark BENCHMARKS[] = {
+    { "fruit_update",     true,  SetupUpdate,    RunUpdate      },
+    { "fruit_respawn",    true,  SetupRespawn,   RunRespawn     },
+    { "catch_query",      true,  SetupCatch,     RunQuery       },
+    { "catch_scan",       true,  SetupCatch,     RunScan        },
+    { "fruit_cull",       true,  SetupCatch,     RunCull        },
+    { "vector_normalize", true,  SetupNormalize, RunNormalize   },
+    { "bitmap_load",      false, SetupBitmap,    RunBitmap      },
+    { "sphere_mesh_12x8", false, SetupSphere,    RunSphereSmall },
+    { "sphere_mesh_32x32",false, SetupSphere,    RunSphereLarge },
+};
+
+// Time one benchmark at one count: find how many iterations make a sample
+// last minTime, then keep the median and fastest of SAMPLES samples
+static Result Measure(const Benchmark& bench, Fixture& fixture, int count, double minTime) {
+    bench.setup(fixture, count);
+
+    // Double the batch until it takes long enough; this also warms caches
+    // and the branch predictors up before anything is recorded
+    int iteration = 0;
+    int iterations = 1;
+    chrono::steady_clock::time_point start;
+    for (;;) {
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            bench.run(fixture, iteration++);
+        }
+        if (SecondsSince(start) >= minTime || iterations >= (1 << 24)) break;
+        iterations *= 2;
+    }
+
+    vector<double> samples;
+    for (int s = 0; s < SAMPLES; ++s) {
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            bench.run(fixture, iteration++);
+        }
+        samples.push_back(SecondsSince(start) * 1e9 / iterations);
+    }
+    sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name       = bench.name;
+    result.count      = count;
+    result.iterations = iterations;
+    result.medianNs   = samples[SAMPLES / 2];
+    result.minNs      = samples[0];
+    return result;
+}
+
+static bool WriteJson(const char* path, const vector<Result>& results, int threads) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n  \"suite\": \"ballquest_bench\",\n");
+    fprintf(file, "  \"build_type\": \"%s\",\n", BALLQUEST_BUILD_TYPE);
+    fprintf(file, "  \"threads\": %d,\n", threads);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"count\": %d, \"iterations\": %d, "
+                      "\"median_ns\": %.1f, \"min_ns\": %.1f, \"ns_per_item\": %.4f}%s\n",
+                r.name.c_str(), r.count, r.iterations, r.medianNs, r.minNs,
+                r.medianNs / max(r.count, 1), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* filter   = nullptr;
+    const char* jsonPath = nullptr;
+    int    maxCount    = 1000000;
+    int    threadCount = 1;
+    double minTime     = 0.02;
+    string bitmapPath  = string(BALLQUEST_SOURCE_DIR) + "/textures/wall.bmp";
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max") == 0 && hasValue) {
+            maxCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threadCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            minTime = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bitmap") == 0 && hasValue) {
+            bitmapPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        }
+        else {
+            fprintf(stderr, "usage: %s [--filter TEXT] [--max N] [--threads N] [--min-time S] "
+                            "[--bitmap FILE] [--json FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Single-threaded by default so results compare across machines
+    JobSystem jobs(threadCount);
+    Fixture fixture;
+    fixture.jobs = jobs.ThreadCount() > 1 ? &jobs : nullptr;
+    fixture.bitmapPath = bitmapPath;
+
+    printf("%s build, %d thread(s)\n", BALLQUEST_BUILD_TYPE, jobs.ThreadCount());
+    printf("%-18s %9s %8s %14s %14s %12s\n", "benchmark", "count", "iters", "median us", "min us", "ns/item");
+
+    vector<Result> results;
+    for (const Benchmark& bench : BENCHMARKS) {
+        if (filter && !strstr(bench.name, filter)) continue;
+
+        for (int count = bench.scales ? 10 : 1; count <= (bench.scales ? maxCount : 1); count *= 10) {
+            Result r = Measure(bench, fixture, count, minTime);
+            printf("%-18s %9d %8d %14.3f %14.3f %12.3f\n", r.name.c_str(), r.count, r.iterations,
+                   r.medianNs / 1000.0, r.minNs / 1000.0, r.medianNs / r.count);
+            fflush(stdout);
+            results.push_back(r);
+        }
+    }
+
+    if (jsonPath && !WriteJson(jsonPath, results, jobs.ThreadCount())) {
+        fprintf(stderr, "%s: cannot write results\n", jsonPath);
+        return 1;
+    }
+    // Printed so the work the benchmarks did can't be optimized away
+    printf("checksum %zu\n", fixture.checksum);
+    return 0;
+}
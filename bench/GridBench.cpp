@@ -0,0 +1,67 @@
+// Broadphase benchmark: per-step catch query cost as the ball count and
+// arena grow together at constant density, grid query vs. full scan.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "../include/Collision.h"
+#include "../include/FruitPool.h"
+#include "../include/Profiler.h"
+
+using namespace std;
+
+// Average balls per square unit of floor, roughly the HARD difficulty density
+const float BALL_DENSITY = 0.25f;
+const int   STEPS        = 200;
+
+int main(int argc, char** argv) {
+    int maxCount = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    printf("%10s %10s %14s %14s %8s\n", "balls", "cells", "grid us/step", "scan us/step", "hits");
+
+    for (int count = 1000; count <= maxCount; count *= 10) {
+        int half = static_cast<int>(std::sqrt(count / BALL_DENSITY) / 2.0f);
+
+        FruitPool fruits(FruitType::MAIN);
+        fruits.SetSpawnArea(half, half);
+        Random random(1);
+        fruits.Reset(count, 0.0f, 50.0f / count, random);
+
+        vector<int> candidates, gridHits, scanHits;
+        double gridTime = 0.0, scanTime = 0.0;
+        long hitCount = 0;
+
+        for (int step = 0; step < STEPS; ++step) {
+            fruits.Update(1.0f / 120.0f, 1.0f);
+
+            // Walk the player in a circle so queries visit different cells
+            float angle = step * 0.05f;
+            Vector3 position(std::cos(angle) * half * 0.5f, 2.0f, std::sin(angle) * half * 0.5f);
+            Vector3 view = position + Vector3(-std::sin(angle), -0.3f, std::cos(angle));
+            CatchVolume volume = MakeCatchVolume(position, view);
+
+            gridHits.clear();
+            auto start = chrono::steady_clock::now();
+            QueryCatches(fruits, volume, candidates, gridHits);
+            gridTime += SecondsSince(start);
+
+            scanHits.clear();
+            start = chrono::steady_clock::now();
+            FindCatches(fruits, volume, scanHits);
+            scanTime += SecondsSince(start);
+
+            if (gridHits != scanHits) {
+                fprintf(stderr, "Mismatch at %d balls, step %d\n", count, step);
+                return 1;
+            }
+            hitCount += gridHits.size();
+            fruits.Refill(count, 50.0f, 0.0f, random);
+        }
+
+        printf("%10d %10d %14.2f %14.2f %8ld\n", count, fruits.GetGrid().CellCount(),
+               gridTime / STEPS * 1e6, scanTime / STEPS * 1e6, hitCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Compare two ballquest_bench JSON result files.
+
+    bench/compare.py BASELINE.json CURRENT.json [--threshold PERCENT]
+
+Benchmarks are matched by name and count and compared on their median time.
+Anything slower than the baseline by more than the threshold (10% by
+default) is flagged, and the exit status is 1 if anything was.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    results = {(r["name"], r["count"]): r for r in data["results"]}
+    return data, results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmark regressions against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="slowdown in percent that counts as a regression (default 10)")
+    args = parser.parse_args()
+
+    base_info, base = load(args.baseline)
+    cur_info, cur = load(args.current)
+
+    for key in ("build_type", "threads"):
+        if base_info.get(key) != cur_info.get(key):
+            print("warning: %s differs (baseline %s, current %s)"
+                  % (key, base_info.get(key), cur_info.get(key)))
+
+    limit = 1.0 + args.threshold / 100.0
+    regressions = 0
+    print("%-18s %9s %14s %14s %8s" % ("benchmark", "count", "baseline us", "current us", "change"))
+    for key, result in cur.items():
+        if key not in base:
+            continue
+        before = base[key]["median_ns"]
+        after = result["median_ns"]
+        ratio = after / before if before > 0 else 1.0
+
+        status = ""
+        if ratio > limit:
+            status = "REGRESSION"
+            regressions += 1
+        elif ratio < 1.0 / limit:
+            status = "faster"
+        print("%-18s %9d %14.3f %14.3f %+7.1f%% %s"
+              % (key[0], key[1], before / 1000.0, after / 1000.0, (ratio - 1.0) * 100.0, status))
+
+    # Filtered or --max limited runs leave some out; not an error
+    missing = len(set(base) - set(cur))
+    if missing:
+        print("%d baseline result(s) not in the current run" % missing)
+
+    if regressions:
+        print("%d regression(s) over %.0f%%" % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <GL/gl.h>
+#include "Texture.h"
+
+class RenderQueue;
+class Frustum;
+
+// Ground and the four walls baked once into a vertex/index buffer. Each
+// face is tessellated into a grid so per-vertex lighting from the point
+// light varies across it instead of looking flat.
+class Arena {
+public:
+    Arena();
+    ~Arena();
+
+    void Init(float size, float groundY, float wallHeight, int tessellation);
+
+    // Up to two opaque items: the untextured ground and the walls with
+    // wallTexture. Faces whose bounds lie outside frustum are left out.
+    void Submit(RenderQueue& queue, const CTexture& wallTexture, const Frustum& frustum);
+
+private:
+    enum { FACE_GROUND, FACE_COUNT = 5 };   // Ground, then the four walls
+
+    struct Face {
+        GLsizei firstIndex;
+        GLsizei indexCount;
+        float   minCorner[3];
+        float   maxCorner[3];
+    };
+
+    static int DrawGround(void* context);
+    static int DrawWalls(void* context);
+    void DrawRange(GLsizei firstIndex, GLsizei count);
+
+    GLuint   m_vertexBuffer;
+    GLuint   m_indexBuffer;
+    Face     m_faces[FACE_COUNT];
+    unsigned m_visibleWalls;   // Bit per wall, from the last Submit()
+};
+
+#endif // ARENA_H
@@ -0,0 +1,86 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <GL/gl.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Texture.h"
+
+// Loads textures in the background. A worker thread maps and parses the
+// files; Poll() on the GL thread then maps a pixel buffer object and hands
+// it back to the worker, which copies the payload from the file mapping
+// straight into it. The GL thread only unmaps the buffer and uploads the
+// levels from there, so it never waits on the disk or touches the texels.
+// Without pixel buffer objects the levels go to GL from the file mapping.
+//
+// Requested CTextures stay empty until their file is resident, and must
+// outlive the request. Call Shutdown() on the GL thread before the context
+// goes away; the destructor can't free GL objects.
+class AssetLoader {
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Queue texture to be filled from path, or from fallback if path
+    // can't be read, parsed or uploaded (a DDS format the driver lacks).
+    // Returns at once; textures already resident are attached immediately.
+    void LoadTexture(CTexture* texture, const char* path, const char* fallback = nullptr);
+
+    // Upload whatever the worker has finished (GL thread, once per frame)
+    void Poll();
+
+    // Block until every queued asset is resident or has failed
+    void Wait();
+
+    bool IsIdle() const { return m_outstanding.load(std::memory_order_acquire) == 0; }
+
+    // Stop the worker and delete the staging buffer (GL thread, context
+    // still current). No loads may be queued afterwards.
+    void Shutdown();
+
+private:
+    struct Job {
+        std::vector<CTexture*>   textures;
+        std::vector<std::string> paths;      // Tried in order
+        size_t                   next;       // First path not tried yet
+        std::string              key;        // Cache key of the path that loaded
+        const unsigned char*     data;       // File mapping, until its payload is uploaded or copied
+        size_t                   dataSize;
+        void*                    staging;    // Mapped PBO for the worker to copy the payload into
+        TextureImage             image;
+        bool                     ok;
+    };
+
+    void WorkerMain();
+    void StopWorker();
+    void StartStaging();
+    void Complete(Job* job);
+    bool Upload(Job& job);
+    static void ReleaseFile(Job& job);
+
+    std::thread             m_worker;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;          // Worker: jobs queued or stopping
+    std::condition_variable m_done;          // Wait(): a job finished
+    std::deque<Job*>        m_queued;
+    std::deque<Job*>        m_finished;
+    std::vector<Job*>       m_pending;       // GL thread's view of all live jobs
+    std::deque<Job*>        m_staging;       // Parsed, waiting for the PBO (GL thread)
+    std::atomic<int>        m_outstanding;   // Queued, loading or awaiting upload
+    bool                    m_stop;
+
+    GLuint     m_pbo;
+    GLsizeiptr m_pboCapacity;
+    Job*       m_pboOwner;                   // Job the PBO is mapped for, if any
+    int        m_usePbo;                     // -1 until the GL version is checked
+};
+
+#endif // ASSETLOADER_H
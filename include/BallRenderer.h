@@ -0,0 +1,53 @@
+#ifndef BALLRENDERER_H
+#define BALLRENDERER_H
+
+#include <vector>
+#include <GL/gl.h>
+#include "FruitPool.h"
+#include "Vector3.h"
+
+class Sphere;
+class RenderQueue;
+
+// Per-instance data streamed to the ball shader
+struct BallInstance {
+    float x, y, z, radius;
+    float r, g, b;
+};
+
+// Draws every active fruit in one instanced call from a single shared
+// sphere mesh. Needs OpenGL 3.3; when Init() fails the pools fall back to
+// FruitPool::Draw().
+class BallRenderer {
+public:
+    BallRenderer();
+    ~BallRenderer();
+
+    bool Init();
+    bool IsAvailable() const { return m_program != 0; }
+
+    // Gathers the instances now and adds one opaque item drawing them with
+    // the GL modelview/projection matrices current when the queue executes
+    // (after CCamera::Look); alpha interpolates between the last two
+    // simulation steps
+    void Submit(RenderQueue& queue, FruitPool& mainFruits, FruitPool& blackFruits,
+                const Vector3& eye, float alpha);
+
+private:
+    static int DrawQueued(void* context);
+    void Draw();
+
+    Sphere* m_sphere;
+    GLuint  m_program;
+    GLuint  m_instanceBuffer;
+    GLsizeiptr m_instanceCapacity;   // In bytes
+    GLint   m_viewLoc;
+    GLint   m_projectionLoc;
+    GLint   m_lightPosLoc;
+    GLint   m_viewPosLoc;
+    Vector3 m_eye;
+
+    std::vector<BallInstance> m_instances;
+};
+
+#endif // BALLRENDERER_H
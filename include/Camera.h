@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include "Vector3.h"
+#include "Frustum.h"
 #include <GL/glut.h>
 
 class CCamera {
@@ -16,7 +17,15 @@ public:
                        float viewX,     float viewY,     float viewZ,
                        float upVectorX, float upVectorY, float upVectorZ);
 
+    // Load the view into the modelview matrix (expected to be identity)
+    // and extract the frustum of it and the current projection
     void Look();
+
+    // World-space frustum as of the last Look()
+    const Frustum& GetFrustum() const { return m_frustum; }
+
+private:
+    Frustum m_frustum;
 };
 
 #endif // CAMERA_H 
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <vector>
+#include "Vector3.h"
+#include "FruitPool.h"
+
+class JobSystem;
+
+// Ring and direct-catch volumes around the player for one step. All
+// distances are squared so the kernels never take a square root.
+struct CatchVolume {
+    Vector3 ringCenter;
+    Vector3 ringNormal;       // Unit view direction
+    float   ringOuterSq;      // RING_RADIUS^2
+    float   ringInnerSq;      // (0.8 * RING_RADIUS)^2
+    Vector3 player;
+    float   catchDistSq;      // CATCH_DISTANCE^2, measured on the XZ plane
+    float   catchTop;         // Top of the catch cylinder, which has no bottom
+};
+
+// Build the catch volume for a player standing at position looking at view
+CatchVolume MakeCatchVolume(const Vector3& position, const Vector3& view);
+
+// Batched ring-crossing and direct-catch test over each fruit's path
+// during the last Update(), from its previous height down to its current
+// one or the floor. Appends the index of every fruit whose path crossed the
+// ring plane inside the annulus, or entered the catch cylinder around the
+// player, to hits in ascending order. Fruits that landed in that step are
+// tested too. The tests are exact at any step length, so fast fruits and
+// long steps can't skip through the ring. Processes 8 fruits per
+// instruction with AVX2.
+void FindCatches(const FruitPool& fruits, const CatchVolume& volume, std::vector<int>& hits);
+
+// Same test restricted to the fruits in the grid cells around the player,
+// so the cost depends on local density instead of the pool size. The
+// candidates buffer is scratch space; hits come back in ascending order.
+// With jobs, large candidate sets are tested in parallel chunks.
+void QueryCatches(const FruitPool& fruits, const CatchVolume& volume,
+                  std::vector<int>& candidates, std::vector<int>& hits,
+                  JobSystem* jobs = nullptr);
+
+#endif // COLLISION_H
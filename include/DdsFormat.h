@@ -0,0 +1,80 @@
+#ifndef DDS_FORMAT_H
+#define DDS_FORMAT_H
+
+#include <cstdint>
+
+// DirectDraw Surface layout shared by the offline converter and the runtime
+// loader:
+//
+//   "DDS " magic
+//   DdsHeader
+//   level 0, level 1, ... level mipCount-1, tightly packed
+//
+// Rows are stored in GL order (bottom row first) so each level uploads as
+// is; other DDS viewers will show the image upside down.
+struct DdsPixelFormat {
+    uint32_t size;                // 32
+    uint32_t flags;               // DDPF_*
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rMask;
+    uint32_t gMask;
+    uint32_t bMask;
+    uint32_t aMask;
+};
+
+struct DdsHeader {
+    uint32_t       size;          // 124
+    uint32_t       flags;         // DDSD_*
+    uint32_t       height;
+    uint32_t       width;
+    uint32_t       pitchOrLinearSize;
+    uint32_t       depth;
+    uint32_t       mipMapCount;
+    uint32_t       reserved1[11];
+    DdsPixelFormat format;
+    uint32_t       caps;          // DDSCAPS_*
+    uint32_t       caps2;
+    uint32_t       caps3;
+    uint32_t       caps4;
+    uint32_t       reserved2;
+};
+
+const uint32_t DDS_MAGIC = 0x20534444;   // "DDS "
+const uint32_t DDS_FOURCC_DXT1 = 0x31545844;   // "DXT1"
+
+const uint32_t DDSD_CAPS        = 0x1;
+const uint32_t DDSD_HEIGHT      = 0x2;
+const uint32_t DDSD_WIDTH       = 0x4;
+const uint32_t DDSD_PITCH       = 0x8;
+const uint32_t DDSD_PIXELFORMAT = 0x1000;
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDSD_LINEARSIZE  = 0x80000;
+
+const uint32_t DDPF_ALPHAPIXELS = 0x1;
+const uint32_t DDPF_FOURCC      = 0x4;
+const uint32_t DDPF_RGB         = 0x40;
+
+const uint32_t DDSCAPS_COMPLEX  = 0x8;
+const uint32_t DDSCAPS_TEXTURE  = 0x1000;
+const uint32_t DDSCAPS_MIPMAP   = 0x400000;
+
+// Bytes in one level: DXT1 packs each 4x4 block into 8 bytes, the
+// uncompressed format is 32-bit BGRA
+inline uint32_t DdsLevelSize(bool dxt1, uint32_t width, uint32_t height) {
+    if (dxt1) return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+    return width * height * 4;
+}
+
+// Levels in a full chain down to 1x1
+inline uint32_t DdsMipCount(uint32_t width, uint32_t height) {
+    uint32_t count = 1;
+    while (width > 1 || height > 1) {
+        width  = width  > 1 ? width  / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ++count;
+    }
+    return count;
+}
+
+#endif // DDS_FORMAT_H
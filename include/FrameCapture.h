@@ -0,0 +1,98 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <GL/gl.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records the frames being drawn without stalling the GL thread. Each
+// Capture() starts an asynchronous glReadPixels into the next pixel buffer
+// object of a small ring, guarded by a fence; a buffer is only mapped when
+// the ring comes back round to it RING_SIZE frames later, by which time the
+// copy has long finished. The mapped pixels are copied into a pooled frame
+// and handed to a worker thread, which flips, encodes and writes them.
+//
+// Output is either a numbered PNG sequence in a directory or raw RGB24
+// frames, top row first, on stdout for a video encoder. When stdout takes
+// frames, everything else the process prints to stdout goes to stderr.
+class FrameCapture {
+public:
+    static const int RING_SIZE = 3;    // Frames a readback stays in flight
+    static const int POOL_SIZE = 8;    // Frames queued for the worker at most
+
+    FrameCapture();
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // target is "-" for raw frames on stdout, otherwise a directory that
+    // gets frame_000000.png, frame_000001.png, ...
+    bool Start(const char* target, int width, int height);
+
+    // Queue a readback of the current read buffer (GL thread, after the
+    // frame is drawn and before it is swapped)
+    void Capture();
+
+    // Capture at a new size from the next frame on (GL thread, when the
+    // window is resized). Readbacks in flight are collected at the old size
+    // first. Raw stdout frames can't change size mid-stream, so there it
+    // finishes the capture instead and returns false.
+    bool Resize(int width, int height);
+
+    // Collect the readbacks still in flight, write everything out and stop
+    // the worker
+    void Finish();
+
+    bool IsActive() const { return m_active; }
+    int  FramesWritten() const { return m_written; }
+
+private:
+    struct Frame {
+        int                  index;
+        int                  width;
+        int                  height;
+        std::vector<uint8_t> pixels;   // RGBA, bottom row first as GL reads it
+    };
+
+    void Collect(int slot);
+    void AllocateBuffers();
+    void WorkerMain();
+    bool WriteFrame(Frame& frame);
+
+    bool m_active;
+    int  m_width;                    // Size readbacks are queued at
+    int  m_height;
+    bool m_toStdout;
+    std::string m_directory;
+    FILE*       m_pipe;
+
+    // GL thread: the readback ring
+    GLuint m_pbo[RING_SIZE];
+    GLsync m_fence[RING_SIZE];
+    int    m_frameOf[RING_SIZE];     // Frame read into each slot, -1 if idle
+    int    m_next;                   // Frames captured so far
+
+    // Shared with the worker
+    std::thread             m_worker;
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;       // Worker: frames queued or stopping
+    std::condition_variable m_freed;      // GL thread: a pooled frame is free
+    std::deque<Frame*>      m_queued;
+    std::vector<Frame*>     m_free;
+    Frame                   m_pool[POOL_SIZE];
+    bool                    m_stop;
+    int                     m_written;    // Worker only until joined
+
+    // Worker scratch: converted rows and the encoded file, reused
+    std::vector<uint8_t> m_rgb;
+    std::vector<uint8_t> m_encoded;
+};
+
+#endif // FRAMECAPTURE_H
@@ -0,0 +1,160 @@
+#ifndef FRUITPOOL_H
+#define FRUITPOOL_H
+
+#include <cstdint>
+#include <vector>
+#include "Vector3.h"
+#include "SpatialGrid.h"
+#include "Random.h"
+
+struct BallInstance;
+class StateReader;
+class JobSystem;
+class Frustum;
+
+enum class FruitType {
+    MAIN,
+    BLACK
+};
+
+// Structure-of-arrays storage for every fruit of one type. Positions, speed
+// and size live in contiguous float arrays padded to FRUIT_LANES, and the
+// active flags are packed into a bitmask, so Update() can integrate whole
+// SIMD lanes at once (AVX2 or SSE2, scalar fallback otherwise). Fruits only
+// fall straight down, so the previous position is (x, prevY, z).
+//
+// Slots are preallocated up to a hard capacity and handed out from a free
+// list, so fruits come and go at any rate without touching the heap.
+// Acquire() and Release() are O(1); free slots are reused lowest first
+// after a Reset(), which keeps live fruits packed at the front and the
+// kernels' loops short.
+class FruitPool {
+public:
+    static const int FRUIT_LANES = 8;
+    static constexpr float GRID_CELL_SIZE = 2.0f;
+    // Fruits that fall past this height have landed
+    static constexpr float FLOOR_HEIGHT = -1.0f;
+
+    explicit FruitPool(FruitType type);
+
+    // Fruits spawn at integer x in [-halfWidth, halfWidth) and z in
+    // [-halfDepth, halfDepth); the broadphase grid covers the same area.
+    void SetSpawnArea(int halfWidth, int halfDepth);
+
+    // Allocate every slot up front and empty the pool. Nothing else
+    // allocates unless a Reset() asks for more than capacity fruits.
+    void Reserve(int capacity);
+    int  Capacity() const { return m_capacity; }
+
+    // Free every slot, then spawn count fruits stacked upward from
+    // baseHeight in spacing steps. Grows the pool if count exceeds capacity.
+    void Reset(int count, float baseHeight, float spacing, Random& random, JobSystem* jobs = nullptr);
+    void Clear();
+
+    // Take a free slot, inactive until spawned; -1 when the pool is full
+    int  Acquire();
+    // Return a slot to the free list, whether it is falling or not
+    void Release(int index);
+    int  LiveCount() const { return m_capacity - static_cast<int>(m_free.size()); }
+
+    // Both split their per-fruit work over jobs when given one; the result
+    // is the same either way
+    void Update(float deltaTime, float speedMultiplier, JobSystem* jobs = nullptr);
+    // Release fruits that have landed, then spawn new ones at height, in
+    // one batch, until target are live or the pool is full. Returns the
+    // number spawned.
+    int  Refill(int target, float height, float gameTime, Random& random, JobSystem* jobs = nullptr);
+
+    // Snapshot of everything the simulation reads; render-only state (the
+    // rainbow timers) is left out. LoadState() rebuilds the grid.
+    void SaveState(std::vector<uint8_t>& out) const;
+    bool LoadState(StateReader& in);
+    // List the active fruits whose sphere touches frustum, alpha in [0, 1]
+    // of the way between their last two simulated heights, lowest slot
+    // first. Tests whole SIMD lanes against all six planes at once.
+    void Cull(const Frustum& frustum, float alpha);
+    const std::vector<int>& Visible() const { return m_visible; }
+    int  CulledCount() const { return m_culled; }
+
+    // Rendering, implemented in FruitDraw.cpp (game target only). Both emit
+    // the fruits the last Cull() found visible, at the same alpha. Draw()
+    // returns the number of spheres drawn.
+    int  Draw(float alpha);
+    void AppendInstances(std::vector<BallInstance>& out, float alpha);
+
+    // Slots [0, Size()) have been used since the last Reset(); everything
+    // past it is free, so loops over the pool stop there
+    int  Size() const { return m_count; }
+    FruitType GetType() const { return m_type; }
+
+    bool IsActive(int index) const {
+        return (m_active[index >> 6] >> (index & 63)) & 1u;
+    }
+    // Falling, or landed during the last Update() and not yet released:
+    // every fruit a catch test for that step has to look at
+    bool IsAllocated(int index) const {
+        return (m_allocated[index >> 6] >> (index & 63)) & 1u;
+    }
+    void SetActive(int index, bool active) {
+        uint64_t bit = uint64_t(1) << (index & 63);
+        if (active) m_active[index >> 6] |= bit;
+        else        m_active[index >> 6] &= ~bit;
+    }
+
+    Vector3 GetPosition(int index) const { return Vector3(m_x[index], m_y[index], m_z[index]); }
+    float   GetSize(int index) const { return m_size[index]; }
+    int     GetPoints(int index) const { return m_points[index]; }
+
+    // Raw lane arrays, padded to a multiple of FRUIT_LANES
+    const float* X() const { return m_x.data(); }
+    const float* Y() const { return m_y.data(); }
+    const float* PrevY() const { return m_prevY.data(); }
+    const float* Z() const { return m_z.data(); }
+    const float* Speed() const { return m_speed.data(); }
+    const float* Sizes() const { return m_size.data(); }
+    const uint64_t* ActiveMask() const { return m_active.data(); }
+    const uint64_t* AllocatedMask() const { return m_allocated.data(); }
+
+    // Broadphase over spawn positions; inactive fruits may still be listed
+    const SpatialGrid& GetGrid() const { return m_grid; }
+
+private:
+    void ReleaseLanded();
+    void UpdateRange(float step, int begin, int end);
+    void Spawn(const int* indices, int count, float gameTime, Random& random, JobSystem* jobs = nullptr);
+    void SetAttributes(int index, float gameTime, uint32_t colorDraw);
+
+    FruitType m_type;
+    int       m_capacity;
+    int       m_count;            // One past the highest slot used since Reset()
+    int       m_spawnHalfWidth;
+    int       m_spawnHalfDepth;
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_prevY;   // Height before the last Update(), for crossing tests
+    std::vector<float> m_z;
+    std::vector<float> m_speed;
+    std::vector<float> m_size;
+    std::vector<uint64_t> m_active;
+    std::vector<uint64_t> m_allocated;   // Slots out of the free list, falling or landed
+    std::vector<int>      m_free;        // Free slot stack, next one on top
+
+    SpatialGrid m_grid;   // Fruits fall straight down, so cells only change on respawn
+
+    // Cold per-fruit attributes, only touched on spawn, score and draw
+    std::vector<Vector3> m_color;
+    std::vector<int>     m_points;
+    std::vector<uint8_t> m_isRainbow;
+    std::vector<float>   m_time;
+
+    // Spawn scratch space, reused every step
+    std::vector<int>      m_spawnIndices;
+    std::vector<uint32_t> m_draws;
+
+    // Result of the last Cull(), reused every frame
+    std::vector<int>      m_visible;
+    int                   m_culled;
+};
+
+#endif // FRUITPOOL_H
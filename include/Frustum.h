@@ -0,0 +1,34 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+// Plane nx*x + ny*y + nz*z + d = 0 with a unit normal pointing into the
+// frustum, so the signed distance of a point is positive inside
+struct FrustumPlane {
+    float nx, ny, nz, d;
+};
+
+// The six clip planes of a camera, in world space. Pure math with no GL,
+// so the simulation core can cull against it headless.
+class Frustum {
+public:
+    enum { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+    Frustum();
+
+    // Planes of projection * modelview. Both are column-major as GL returns
+    // them; with a modelview holding only the view transform the planes are
+    // in world space.
+    void Extract(const float projection[16], const float modelview[16]);
+
+    // Conservative: true for anything touching the frustum, and for a few
+    // spheres and boxes near its corners that don't
+    bool TestSphere(float x, float y, float z, float radius) const;
+    bool TestBox(const float minCorner[3], const float maxCorner[3]) const;
+
+    const FrustumPlane& Plane(int index) const { return m_planes[index]; }
+
+private:
+    FrustumPlane m_planes[PLANE_COUNT];
+};
+
+#endif // FRUSTUM_H
@@ -0,0 +1,158 @@
+#ifndef GAMEWORLD_H
+#define GAMEWORLD_H
+
+#include "Vector3.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FruitPool.h"
+
+class JobSystem;
+
+// Arena and gameplay constants shared by the simulation and the renderer
+const float GROUND_SIZE   = 50.0f;
+const float GROUND_Y      = 0.0f;
+const float WALL_DISTANCE = GROUND_SIZE;
+const float WALL_BUFFER   = 1.0f;
+
+const int   BallHeight = 50;
+
+const float CATCH_DISTANCE = 0.8f;
+const float RING_RADIUS    = CATCH_DISTANCE;
+
+const float GAME_DURATION      = 120.0f;
+const float EXPLOSION_DURATION = 2.0f;
+
+// Fixed simulation rate. Frames run as many steps as fit in the elapsed
+// time, up to MAX_CATCHUP_STEPS; anything beyond that is dropped.
+const float SIM_STEP          = 1.0f / 120.0f;
+const int   MAX_CATCHUP_STEPS = 8;
+
+enum Difficulty {
+    EASY,
+    MEDIUM,
+    HARD
+};
+
+// Live ball counts over a round. Each step the spawn controller tops the
+// pools up to a target that ramps linearly from start to peak over
+// GAME_DURATION, so balls get denser as the clock runs down.
+struct SpawnSchedule {
+    int mainStart;
+    int mainPeak;
+    int blackStart;
+    int blackPeak;
+};
+
+// The schedule Start(diff) uses
+SpawnSchedule DefaultSpawnSchedule(Difficulty diff);
+
+// Player input for one simulation step
+struct GameInput {
+    bool  forward  = false;
+    bool  backward = false;
+    bool  left     = false;
+    bool  right    = false;
+    bool  sprint   = false;
+    float yawDelta   = 0.0f;   // Mouse look, in degrees
+    float pitchDelta = 0.0f;
+    float speedDelta = 0.0f;   // AdjustSpeed() before the step (+/- keys)
+    bool  endGame    = false;  // Player ended the game (Z)
+};
+
+// Self-contained game simulation. Has no OpenGL/GLUT dependency and is
+// advanced only through Step(), so it can run headless at any rate.
+class GameWorld {
+public:
+    GameWorld();
+
+    // Seed for the world's random stream, applied by the next Start()
+    void SetSeed(uint32_t seed) { m_seed = seed; }
+    uint32_t GetSeed() const { return m_seed; }
+
+    // Split the ball update, catch tests and respawns over jobs (nullptr
+    // for single-threaded). Steps give bit-identical results either way.
+    void SetJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+
+    // Allocate the ball pools up front; the peak counts of every schedule
+    // that will run should fit, so rounds never touch the heap. Start()
+    // grows a pool that is too small.
+    void ReserveFruits(int mainCapacity, int blackCapacity);
+
+    void Start(Difficulty diff);
+    void Start(Difficulty diff, int mainCount, int blackCount);  // Fixed counts for stress runs
+    void Start(Difficulty diff, const SpawnSchedule& schedule);
+    void Step(float deltaTime, const GameInput& input);
+    void EndGame();
+    void AdjustSpeed(float delta);
+
+    bool IsPlaying() const { return m_playing; }
+    bool IsOver() const { return m_over; }
+    Difficulty GetDifficulty() const { return m_difficulty; }
+    const SpawnSchedule& GetSpawnSchedule() const { return m_schedule; }
+
+    int   GetScore() const { return m_score; }
+    int   GetLife() const { return m_life; }
+    float GetGameTime() const { return m_gameTime; }
+    float GetRemainingTime() const;
+    float GetCameraSpeed() const { return m_cameraSpeed; }
+    float GetFruitSpeedMultiplier() const { return m_fruitSpeedMultiplier; }
+
+    bool  IsExploding() const { return m_isExploding; }
+    float GetExplosionTime() const { return m_explosionTime; }
+
+    // Player viewpoint, matching CCamera's position/view/up vectors
+    const Vector3& GetPosition() const { return m_position; }
+    const Vector3& GetView() const { return m_view; }
+    const Vector3& GetUpVector() const { return m_upVector; }
+
+    FruitPool& GetMainFruits() { return m_mainFruits; }
+    FruitPool& GetBlackFruits() { return m_blackFruits; }
+    const FruitPool& GetMainFruits() const { return m_mainFruits; }
+    const FruitPool& GetBlackFruits() const { return m_blackFruits; }
+
+    // Complete simulation state, including the spawn random stream, so a
+    // loaded world steps on exactly as the saved one would have
+    void SaveState(std::vector<uint8_t>& out) const;
+    bool LoadState(const uint8_t* data, size_t size);
+
+private:
+    void ApplyLook(const GameInput& input);
+    void ApplyMovement(const GameInput& input);
+    void CheckCollisions();
+    void CheckFruits(FruitPool& fruits, bool explodes);
+    void ScoreFruit(FruitPool& fruits, int index, bool explodes);
+    int  TargetCount(int start, int peak) const;
+
+    bool       m_playing;
+    bool       m_over;
+    Difficulty m_difficulty;
+    uint32_t   m_seed;
+    SpawnSchedule m_schedule;
+
+    int   m_score;
+    int   m_life;
+    float m_gameTime;
+    float m_cameraSpeed;
+    float m_fruitSpeedMultiplier;
+
+    bool  m_isExploding;
+    float m_explosionTime;
+
+    Vector3 m_position;
+    Vector3 m_view;
+    Vector3 m_upVector;
+    float   m_yaw;
+    float   m_pitch;
+
+    FruitPool m_mainFruits;
+    FruitPool m_blackFruits;
+    Random    m_random;   // Spawn positions, speeds and colors
+    JobSystem* m_jobs;    // Not owned, may be null
+
+    // Scratch buffers reused across steps
+    std::vector<int> m_candidates;
+    std::vector<int> m_hits;
+};
+
+#endif // GAMEWORLD_H
@@ -0,0 +1,84 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool for data-parallel loops. ParallelFor()
+// cuts a range into chunks and deals them round-robin onto one deque per
+// thread; each thread pops its own deque from the back and, once it runs
+// dry, steals from the front of the others. The calling thread works too
+// and returns when every chunk is done.
+//
+// Chunks only ever cover disjoint ranges, so a body that writes nothing
+// but its own range gives the same result however the range is split.
+// Workers start on the first call that actually splits, so an unused pool
+// costs nothing. ParallelFor() must not be called from several threads at
+// once or from inside a body.
+class JobSystem {
+public:
+    typedef void (*RangeFunc)(void* context, int begin, int end);
+
+    // threadCount includes the caller; 0 means one per hardware thread
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int ThreadCount() const { return m_threadCount; }
+
+    // Run func(context, begin, end) over [0, count). Chunk boundaries are
+    // multiples of grain, and a count of at most grain runs inline.
+    void ParallelFor(int count, int grain, RangeFunc func, void* context);
+
+    template <typename Body>
+    void ParallelFor(int count, int grain, Body& body) {
+        ParallelFor(count, grain, &CallBody<Body>, &body);
+    }
+
+private:
+    struct Batch {
+        std::atomic<int> remaining;
+    };
+
+    struct Task {
+        RangeFunc func;
+        void*     context;
+        int       begin;
+        int       end;
+        Batch*    batch;
+    };
+
+    // Owner takes from the back, thieves from the front
+    struct Queue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    template <typename Body>
+    static void CallBody(void* context, int begin, int end) {
+        (*static_cast<Body*>(context))(begin, end);
+    }
+
+    void Start();
+    void WorkerMain(int index);
+    bool TakeTask(int index, Task& task);
+    void RunTask(const Task& task);
+
+    int m_threadCount;
+    std::vector<std::unique_ptr<Queue>> m_queues;   // [0] is the caller's
+    std::vector<std::thread>            m_workers;
+
+    std::mutex              m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int>        m_queued;   // Tasks sitting in any deque
+    bool                    m_stop;
+};
+
+#endif // JOBSYSTEM_H
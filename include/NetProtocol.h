@@ -0,0 +1,159 @@
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GameWorld.h"
+
+// Client/server protocol for ballquest_server. Every datagram starts with
+// a NetMessage byte; fields follow in host byte order through
+// StateWriter/StateReader, like replays and save states, so both ends must
+// be the same machine type.
+//
+//   client                          server
+//   CONNECT  difficulty      ->
+//                            <-     ACCEPT  session, tick rate
+//   INPUT    ack, last inputs ->                       every tick
+//                            <-     SNAPSHOT tick, base tick, delta
+//   DISCONNECT  session      ->
+//   STATS_REQUEST            ->
+//                            <-     STATS   load and traffic counters
+//
+// Inputs are sent with the previous NET_INPUT_REDUNDANCY - 1 ones attached,
+// so a lost datagram loses no look movement. Snapshots are delta-encoded
+// against the newest snapshot the client acknowledged, or sent whole when
+// that one is no longer in the server's history.
+const uint32_t NET_PROTOCOL_VERSION  = 1;
+const uint16_t NET_DEFAULT_PORT      = 27720;
+const int      NET_INPUT_REDUNDANCY  = 4;
+const int      NET_SNAPSHOT_HISTORY  = 32;      // Ticks a snapshot stays usable as a base
+const uint32_t NET_NO_TICK           = 0xFFFFFFFFu;
+const size_t   NET_MAX_DATAGRAM      = 65507;   // Largest UDP payload over IPv4
+
+enum NetMessage {
+    NET_CONNECT = 1,
+    NET_ACCEPT,
+    NET_INPUT,
+    NET_SNAPSHOT,
+    NET_DISCONNECT,
+    NET_STATS_REQUEST,
+    NET_STATS
+};
+
+// Message bodies, each written whole after its NetMessage byte. Fields
+// are ordered so the structs have no padding.
+
+struct NetConnect {
+    uint32_t version;         // NET_PROTOCOL_VERSION
+    uint32_t nonce;           // Client's pick; repeated CONNECTs get the same session
+    uint32_t difficulty;
+};
+
+const uint16_t NET_NO_SESSION = 0xFFFF;
+
+struct NetAccept {
+    uint32_t nonce;
+    float    tickRate;        // Snapshots per second, and inputs expected
+    uint16_t session;         // NET_NO_SESSION if the server is full
+    uint16_t reserved;
+};
+
+// INPUT is a NetInputHeader followed by count NetInputs, newest first
+struct NetInputHeader {
+    uint32_t ackTick;         // Newest snapshot the client decoded, or NET_NO_TICK
+    uint16_t session;
+    uint8_t  count;
+    uint8_t  reserved;
+};
+
+// One tick of input. Keys use the REPLAY_KEY_* bits; look deltas are in
+// hundredths of a degree.
+struct NetInput {
+    uint32_t sequence;
+    int16_t  yawDelta;
+    int16_t  pitchDelta;
+    uint8_t  keys;
+    uint8_t  reserved[3];
+};
+
+// SNAPSHOT is a NetSnapshotHeader followed by EncodeSnapshot() output
+struct NetSnapshotHeader {
+    uint32_t tick;
+    uint32_t baseTick;        // Snapshot the delta is against, or NET_NO_TICK
+    uint32_t hash;            // HashSnapshot() of the encoded state
+    uint16_t session;
+    uint16_t reserved;
+};
+
+// DISCONNECT is the session as a uint16_t; STATS_REQUEST has no body
+
+// Server counters since it started; a client samples them twice and
+// divides the differences
+struct NetServerStats {
+    uint32_t threads;
+    float    tickRate;
+    uint64_t ticks;
+    uint64_t sessionTicks;    // Sum over ticks of the live session count
+    uint64_t overruns;        // Ticks that took longer than the tick interval
+    double   cpuSeconds;      // Process CPU time
+    double   wallSeconds;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+};
+
+// Quantized ball: position in 1/16 units horizontally and 1/32 vertically
+struct NetBall {
+    int16_t x;
+    int16_t z;
+    int16_t y;
+    uint8_t flags;            // NET_BALL_* bits
+};
+
+enum NetBallFlag {
+    NET_BALL_ACTIVE = 1 << 0,
+    NET_BALL_BLACK  = 1 << 1,
+    NET_BALL_BONUS  = 1 << 2  // Worth 2 points
+};
+
+// Quantized player and round state
+struct NetPlayer {
+    int16_t  x, y, z;         // 1/64 units
+    int16_t  yaw, pitch;      // Hundredths of a degree
+    int16_t  score;
+    int8_t   life;
+    uint8_t  flags;           // NET_PLAYER_* bits
+    uint16_t timeLeft;        // Tenths of a second
+    uint16_t round;           // Rounds started in this session
+};
+
+enum NetPlayerFlag {
+    NET_PLAYER_EXPLODING = 1 << 0
+};
+
+// Everything a snapshot carries. Ball slots are the main pool's slots
+// [0, Size()) followed by the black pool's.
+struct NetSnapshot {
+    NetPlayer            player;
+    uint16_t             mainCount;
+    uint16_t             blackCount;
+    std::vector<NetBall> balls;
+};
+
+// Quantize world's current state into out
+void CaptureSnapshot(const GameWorld& world, uint16_t round, NetSnapshot& out);
+
+// Append state, delta-encoded against base (nullptr: against an all-zero
+// state, i.e. sent whole). Only fields that differ from base are written,
+// and falling balls' heights as one-byte steps when they fit.
+void EncodeSnapshot(const NetSnapshot& state, const NetSnapshot* base, std::vector<uint8_t>& out);
+
+// Rebuild the state EncodeSnapshot() was given from the same base.
+// Returns false on a truncated or malformed payload.
+bool DecodeSnapshot(const uint8_t* data, size_t size, const NetSnapshot* base, NetSnapshot& out);
+
+// FNV-1a of a snapshot, sent alongside it so clients can check that the
+// state they rebuilt is the one the server encoded
+uint32_t HashSnapshot(const NetSnapshot& state);
+
+#endif // NETPROTOCOL_H
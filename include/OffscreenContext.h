@@ -0,0 +1,35 @@
+#ifndef OFFSCREENCONTEXT_H
+#define OFFSCREENCONTEXT_H
+
+#include <GL/gl.h>
+
+// Somewhere to render without a visible window, for benchmarking on
+// machines with no display. InitEgl() makes a windowless EGL context
+// current (Mesa's surfaceless platform, else the default display), needing
+// no X server; when that fails the caller can make a hidden GLUT window
+// current instead. Either way InitFramebuffer() then binds a color and
+// depth framebuffer object that every draw goes to, so nothing waits on
+// vsync.
+class OffscreenContext {
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // False when built without EGL or no EGL display can be opened
+    bool InitEgl();
+    bool InitFramebuffer(int width, int height);
+
+    bool IsEgl() const { return m_context != nullptr; }
+
+private:
+    void*  m_display;   // EGLDisplay and EGLContext, kept opaque so the
+    void*  m_context;   // EGL headers stay out of this one
+    GLuint m_framebuffer;
+    GLuint m_colorBuffer;
+    GLuint m_depthBuffer;
+};
+
+#endif // OFFSCREENCONTEXT_H
@@ -0,0 +1,124 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Frame phases timed by ProfileScope
+enum ProfilePhase {
+    PHASE_INPUT,
+    PHASE_UPDATE,       // FruitPool::Update for both pools
+    PHASE_COLLISION,
+    PHASE_RESET,        // Respawning inactive fruits
+    PHASE_ARENA,
+    PHASE_RING,
+    PHASE_BALLS,
+    PHASE_HUD,
+    PHASE_CAPTURE,      // Frame capture readback on the GL thread
+    PHASE_COUNT
+};
+
+// Per-frame counts recorded next to the timings
+enum ProfileCounter {
+    COUNTER_DRAW_CALLS,
+    COUNTER_STATE_CHANGES,  // GL enables, binds and program switches
+    COUNTER_BALLS_DRAWN,    // Fruits inside the view frustum
+    COUNTER_BALLS_CULLED,   // Active fruits skipped outside it
+    COUNTER_COUNT
+};
+
+// Milliseconds spent in each phase during one frame. Phases that run once
+// per simulation step are summed over all steps of the frame.
+struct FrameSample {
+    float phaseMs[PHASE_COUNT];
+    float frameMs;      // Time since the previous EndFrame()
+    uint32_t counters[COUNTER_COUNT];
+};
+
+struct PhaseStats {
+    float averageMs;
+    float p99Ms;
+};
+
+// Per-frame phase timings kept in a fixed ring of the last CAPACITY frames.
+// Scopes add into the frame being recorded; EndFrame() copies it into the
+// ring and publishes it with one atomic store, so readers never take a
+// lock. There is a single writer (the game thread).
+class Profiler {
+public:
+    static const int CAPACITY = 8192;
+
+    static Profiler& Get();
+
+    // Disabled by default so headless runs pay nothing for the scopes
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+    bool IsEnabled() const { return m_enabled; }
+
+    void Add(ProfilePhase phase, float ms) { m_current.phaseMs[phase] += ms; }
+    void Count(ProfileCounter counter, uint32_t n) { m_current.counters[counter] += n; }
+    void EndFrame();
+    void DiscardFrame();   // Drop the frame being recorded, e.g. after the menu
+
+    // Copy up to maxCount of the newest frames, oldest first
+    int  Recent(FrameSample* out, int maxCount) const;
+
+    // Average and 99th percentile per phase (index PHASE_COUNT is the whole
+    // frame) over the last window frames. Returns the frames used.
+    int  ComputeStats(int window, PhaseStats out[PHASE_COUNT + 1]) const;
+
+    // Every frame still in the ring, one row per frame: phases in
+    // milliseconds, then the counters
+    bool ExportCsv(const char* path) const;
+
+    static const char* PhaseName(ProfilePhase phase);
+    static const char* CounterName(ProfileCounter counter);
+
+private:
+    Profiler();
+
+    bool        m_enabled;
+    FrameSample m_current;
+    std::chrono::steady_clock::time_point m_frameStart;
+
+    FrameSample           m_samples[CAPACITY];
+    std::atomic<uint64_t> m_written;   // Frames published so far
+
+    // Scratch space for ComputeStats(), reused every call
+    mutable std::vector<FrameSample> m_statFrames;
+    mutable std::vector<float>       m_statValues;
+};
+
+// Adds the time until the end of the enclosing block to a phase
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase)
+        : m_phase(phase), m_active(Profiler::Get().IsEnabled()) {
+        if (m_active) m_start = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() {
+        if (!m_active) return;
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+        Profiler::Get().Add(m_phase, elapsed.count());
+    }
+
+private:
+    ProfilePhase m_phase;
+    bool         m_active;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Wall seconds on the steady clock since start, for the benchmarks' and
+// tools' timings
+inline double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Sample at index round(fraction * (n - 1)) of sorted, fraction in [0, 1];
+// sorted must not be empty. Used for every percentile the game and tools
+// print, so they agree on the same samples.
+float Percentile(const std::vector<float>& sorted, float fraction);
+
+#endif // PROFILER_H
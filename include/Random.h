@@ -0,0 +1,48 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// xoshiro128** generator, seeded through splitmix64. Each GameWorld owns
+// one, so simulations running side by side never share or disturb each
+// other's streams, and the whole state fits in a snapshot.
+class Random {
+public:
+    struct State {
+        uint32_t s[4];
+    };
+
+    explicit Random(uint64_t seed = 1) { Seed(seed); }
+
+    void Seed(uint64_t seed);
+
+    uint32_t Next() {
+        const uint32_t result = Rotl(m_state.s[1] * 5, 7) * 9;
+        const uint32_t t = m_state.s[1] << 9;
+        m_state.s[2] ^= m_state.s[0];
+        m_state.s[3] ^= m_state.s[1];
+        m_state.s[1] ^= m_state.s[2];
+        m_state.s[0] ^= m_state.s[3];
+        m_state.s[2] ^= t;
+        m_state.s[3] = Rotl(m_state.s[3], 11);
+        return result;
+    }
+
+    // count draws in one go
+    void Fill(uint32_t* out, int count);
+
+    // Map a draw onto [0, range) with a multiply instead of a division
+    static uint32_t Below(uint32_t draw, uint32_t range) {
+        return static_cast<uint32_t>((uint64_t(draw) * range) >> 32);
+    }
+
+    const State& GetState() const { return m_state; }
+    void SetState(const State& state) { m_state = state; }
+
+private:
+    static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    State m_state;
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,88 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include <GL/gl.h>
+#include "Profiler.h"
+
+// Parts of the frame, drawn in this order
+enum RenderPass {
+    PASS_OPAQUE,        // 3D, sorted by state
+    PASS_TRANSLUCENT,   // 3D and blended, in submission order
+    PASS_OVERLAY,       // Window pixels with y down, in submission order
+    PASS_COUNT
+};
+
+// GL state an item draws with. The queue sets it before the item's draw
+// function runs, so draw functions never toggle these themselves.
+struct RenderState {
+    GLuint program;     // 0 for fixed function
+    GLuint texture;     // GL_TEXTURE_2D is disabled when 0
+    bool   blend;       // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    bool   lighting;
+    bool   depthTest;
+};
+
+// Issues the item's geometry and returns the number of draw calls made
+typedef int (*RenderFunc)(void* context);
+
+struct RenderStats {
+    int items;
+    int drawCalls;
+    int stateChanges;   // Enables, disables, binds and program switches
+};
+
+// Per-frame list of draw items. Submit() only records; Execute() sorts by
+// a key of pass, program, texture and fixed-function state, sets each
+// item's state with redundant changes skipped, and calls its draw function.
+// Opaque items are grouped by state; translucent and overlay items keep the
+// order they were submitted in.
+//
+// Between frames GL is left in the default state: no program, no texture,
+// no blending, lighting and depth test on.
+class RenderQueue {
+public:
+    RenderQueue();
+
+    // Window size for the overlay pass's orthographic projection
+    void SetViewport(int width, int height);
+    int  GetWidth() const { return m_width; }
+    int  GetHeight() const { return m_height; }
+
+    // Time spent in draw is added to phase
+    void Submit(RenderPass pass, const RenderState& state, ProfilePhase phase,
+                RenderFunc draw, void* context);
+
+    // Draw and clear everything submitted since the last Execute(); the
+    // counts go to GetStats() and the profiler
+    void Execute();
+
+    const RenderStats& GetStats() const { return m_stats; }
+
+private:
+    struct Command {
+        RenderPass   pass;
+        RenderState  state;
+        ProfilePhase phase;
+        RenderFunc   draw;
+        void*        context;
+    };
+
+    struct SortItem {
+        uint64_t key;
+        uint32_t command;
+    };
+
+    void Apply(const RenderState& state, bool force);
+    void SetEnabled(GLenum capability, bool& current, bool wanted, bool force);
+
+    std::vector<Command>  m_commands;
+    std::vector<SortItem> m_order;
+    RenderState m_current;
+    bool        m_texturing;   // GL_TEXTURE_2D enabled
+    RenderStats m_stats;
+    int         m_width, m_height;
+};
+
+#endif // RENDERQUEUE_H
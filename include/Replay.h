@@ -0,0 +1,127 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GameWorld.h"
+
+// Replay file layout, all little-endian host structs:
+//
+//   ReplayHeader
+//   ReplayKeyframe[keyframeCount]   index, one entry per keyframeInterval steps
+//   ReplayEvent[eventCount]         inputs, ordered by step
+//   keyframe snapshots              GameWorld::SaveState() blobs
+//
+// Steps are fixed SIM_STEP ticks counted from Start(). An event is written
+// only for steps whose input differs from "same keys as before, no look,
+// no speed change", so an idle player costs nothing.
+const uint32_t REPLAY_VERSION = 4;
+
+struct ReplayHeader {
+    char     magic[4];            // "BQRP"
+    uint32_t version;
+    uint32_t seed;
+    int32_t  difficulty;
+    int32_t  mainCount;           // Live balls at the start
+    int32_t  blackCount;
+    float    step;                // Seconds per step
+    uint32_t stepCount;
+    uint32_t keyframeInterval;    // Steps between keyframes
+    uint32_t keyframeCount;
+    uint32_t eventCount;
+    int32_t  finalScore;
+    int32_t  finalLife;
+    uint32_t reserved;
+    uint64_t finalHash;           // FNV-1a of the final SaveState()
+};
+
+struct ReplayKeyframe {
+    uint32_t step;
+    uint32_t firstEvent;          // First event at or after step
+    uint32_t keys;                // Held keys going into step
+    uint32_t size;                // Snapshot bytes
+    uint64_t offset;              // Snapshot position in the file
+};
+
+struct ReplayEvent {
+    uint32_t step;
+    uint32_t keys;                // REPLAY_KEY_* bits, held from this step on
+    float    yawDelta;
+    float    pitchDelta;
+    float    speedDelta;
+};
+
+enum ReplayKey {
+    REPLAY_KEY_FORWARD  = 1 << 0,
+    REPLAY_KEY_BACKWARD = 1 << 1,
+    REPLAY_KEY_LEFT     = 1 << 2,
+    REPLAY_KEY_RIGHT    = 1 << 3,
+    REPLAY_KEY_SPRINT   = 1 << 4,
+    REPLAY_KEY_END_GAME = 1 << 5
+};
+
+// FNV-1a over a SaveState() blob, used to check that playback reproduced
+// the recorded game bit for bit
+uint64_t HashWorldState(const std::vector<uint8_t>& state);
+
+// Collects the inputs of one game in memory and writes the replay file at
+// the end, once the keyframe and event counts are known.
+class ReplayRecorder {
+public:
+    ReplayRecorder();
+
+    // Call right after world.Start()
+    void Begin(const GameWorld& world, Difficulty difficulty, uint32_t keyframeInterval);
+
+    // Call before every world.Step(SIM_STEP, input)
+    void RecordStep(const GameWorld& world, const GameInput& input);
+
+    bool Finish(const GameWorld& world, const char* path);
+    bool IsRecording() const { return m_recording; }
+
+private:
+    void AddKeyframe(const GameWorld& world);
+
+    bool         m_recording;
+    ReplayHeader m_header;
+    uint32_t     m_keys;
+
+    std::vector<ReplayKeyframe> m_keyframes;
+    std::vector<ReplayEvent>    m_events;
+    std::vector<uint8_t>        m_snapshots;   // Offsets relative to this buffer until Finish()
+};
+
+// Plays a replay file back through a GameWorld. The file is memory-mapped;
+// seeking loads the keyframe at or before the target step straight from
+// the index and simulates at most keyframeInterval - 1 steps from there.
+class ReplayPlayer {
+public:
+    ReplayPlayer();
+    ~ReplayPlayer();
+
+    bool Open(const char* path);
+    void Close();
+
+    const ReplayHeader& GetHeader() const { return *m_header; }
+    uint32_t GetStep() const { return m_step; }
+    bool     IsFinished() const { return m_step >= m_header->stepCount; }
+
+    bool Seek(GameWorld& world, uint32_t step);
+
+    // Run up to count steps, stopping at the end of the recording
+    uint32_t Advance(GameWorld& world, uint32_t count);
+
+private:
+    const uint8_t*        m_data;
+    size_t                m_size;
+    const ReplayHeader*   m_header;
+    const ReplayKeyframe* m_keyframes;
+    const ReplayEvent*    m_events;
+
+    uint32_t m_step;
+    uint32_t m_nextEvent;
+    uint32_t m_keys;
+};
+
+#endif // REPLAY_H
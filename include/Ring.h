@@ -0,0 +1,25 @@
+#ifndef RING_H
+#define RING_H
+
+#include <GL/gl.h>
+#include "Vector3.h"
+
+// Catch ring baked once into a static vertex buffer: the translucent
+// annulus plus its inner and outer borders as one triangle strip with
+// per-vertex color, so drawing it is a matrix load and one draw call.
+class Ring {
+public:
+    Ring();
+    ~Ring();
+
+    void Init(float innerRadius, float outerRadius, int segments);
+
+    // Draw centered at center, facing along the unit vector normal
+    void Draw(const Vector3& center, const Vector3& normal);
+
+private:
+    GLuint  m_vertexBuffer;
+    GLsizei m_vertexCount;
+};
+
+#endif // RING_H
@@ -0,0 +1,76 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Flat binary snapshots of simulation state. Values are copied in host
+// byte order, so snapshots are only read back on the machine type that
+// wrote them.
+class StateWriter {
+public:
+    explicit StateWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be plain data");
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        m_out.insert(m_out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Element count followed by the elements
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be plain data");
+        Write(static_cast<uint32_t>(values.size()));
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        m_out.insert(m_out.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+};
+
+// Reads back what StateWriter wrote. Once a read runs past the end every
+// later read fails too, so callers can check Ok() once at the end.
+class StateReader {
+public:
+    StateReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_offset(0), m_failed(false) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be plain data");
+        if (m_failed || m_size - m_offset < sizeof(T)) {
+            m_failed = true;
+            return false;
+        }
+        memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool ReadArray(std::vector<T>& values) {
+        uint32_t count = 0;
+        if (!Read(count) || (m_size - m_offset) / sizeof(T) < count) {
+            m_failed = true;
+            return false;
+        }
+        values.resize(count);
+        memcpy(values.data(), m_data + m_offset, count * sizeof(T));
+        m_offset += count * sizeof(T);
+        return true;
+    }
+
+    bool Ok() const { return !m_failed; }
+
+private:
+    const uint8_t* m_data;
+    size_t         m_size;
+    size_t         m_offset;
+    bool           m_failed;
+};
+
+#endif // SERIALIZE_H
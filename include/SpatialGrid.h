@@ -0,0 +1,40 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+
+// Uniform grid over the XZ floor. Each cell keeps an intrusive doubly
+// linked list of item indices, so moving an item between cells is O(1)
+// and the grid is maintained incrementally instead of rebuilt per frame.
+// Positions outside the bounds are clamped into the border cells.
+class SpatialGrid {
+public:
+    SpatialGrid();
+
+    void Configure(float minX, float minZ, float maxX, float maxZ, float cellSize);
+    void Resize(int count);                    // Drops every item from the grid
+    void Move(int index, float x, float z);    // Insert or relink an item
+    void Remove(int index);
+
+    // Append every item whose cell overlaps the given XZ rectangle
+    void Query(float minX, float minZ, float maxX, float maxZ, std::vector<int>& out) const;
+
+    int CellCount() const { return m_cols * m_rows; }
+
+private:
+    int Column(float x) const;
+    int Row(float z) const;
+
+    float m_minX;
+    float m_minZ;
+    float m_invCellSize;
+    int   m_cols;
+    int   m_rows;
+
+    std::vector<int> m_head;   // First item per cell, -1 if empty
+    std::vector<int> m_next;
+    std::vector<int> m_prev;
+    std::vector<int> m_cell;   // Cell per item, -1 if not in the grid
+};
+
+#endif // SPATIALGRID_H
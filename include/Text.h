@@ -2,11 +2,55 @@
 #define TEXT_H
 
 #include <string>
+#include <vector>
 #include <GL/glut.h>
 
+class RenderQueue;
+
+// Screen-space text batched per frame. Init() bakes the GLUT Helvetica 18
+// glyphs into an atlas texture once; Queue() only records strings, and
+// Submit() adds one overlay item that turns them into textured quads in one
+// vertex buffer and draws them with a single call. Without framebuffer
+// objects the item falls back to glutBitmapCharacter.
 class Text {
 public:
-    void RenderText(float x, float y, const std::string& text);
+    Text();
+    ~Text();
+
+    // Needs a current GL context and glutInit
+    bool Init();
+    bool IsAvailable() const { return m_atlas != 0; }
+
+    // Baseline at (x, y) in window pixels, y pointing down
+    void Queue(float x, float y, const char* text, float r, float g, float b);
+
+    // Draw everything queued so far when the render queue executes
+    void Submit(RenderQueue& queue);
+
+private:
+    struct Run {
+        float x, y;
+        float r, g, b;
+        int   first, count;   // Range in m_chars
+    };
+
+    struct GlyphVertex {
+        float x, y, u, v;
+        GLubyte r, g, b, a;
+    };
+
+    static int DrawQueued(void* context);
+    int  Draw();
+    int  DrawBitmap();
+
+    GLuint m_atlas;
+    GLuint m_vertexBuffer;
+    GLsizeiptr m_vertexCapacity;   // In bytes
+    int    m_advance[128];
+
+    std::vector<Run>         m_runs;
+    std::string              m_chars;
+    std::vector<GlyphVertex> m_vertices;
 };
 
-#endif // TEXT_H 
\ No newline at end of file
+#endif // TEXT_H
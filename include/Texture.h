@@ -2,26 +2,95 @@
 #define TEXTURE_H
 
 #include <GL/glut.h>
+#include <cstddef>
 #include <string>
+#include <vector>
 
-// Texture loading function
-int LoadBitmap(char* filename);
+// One mip level inside a parsed file's pixel payload
+struct TextureLevel {
+    int    width;
+    int    height;
+    size_t offset;                // From the start of the payload
+    size_t size;
+};
+
+// A texture file parsed into what GL needs to upload it. The pixel payload
+// is a byte range of the file, so it can go to GL from a mapping, a read
+// buffer or a pixel buffer object alike.
+struct TextureImage {
+    int    width;
+    int    height;
+    bool   compressed;            // DXT1 blocks rather than raw texels
+    GLenum internalFormat;
+    GLenum format;                // Texel layout when not compressed
+    bool   topDown;               // BMP stored top row first
+    size_t stride;                // BMP row pitch, padded to 4 bytes
+    size_t payloadOffset;         // Pixel bytes within the file
+    size_t payloadSize;
+    std::vector<TextureLevel> levels;
+};
+
+// Map a whole file read-only for parsing and uploading in place. Returns
+// nullptr if it can't be opened or is empty.
+const unsigned char* MapTextureFile(const char* filename, size_t& fileSize);
+void UnmapTextureFile(const unsigned char* data, size_t fileSize);
+
+// Parse an uncompressed 24/32-bit BMP, or a DDS written by
+// ballquest_texconv (DXT1 or 32-bit BGRA), without touching GL, so any
+// thread can do it. ParseTextureFile reads names ending in .dds as DDS and
+// anything else as BMP.
+bool ParseBitmap(const char* filename, const unsigned char* data, size_t size, TextureImage& image);
+bool ParseDds(const char* filename, const unsigned char* data, size_t size, TextureImage& image);
+bool ParseTextureFile(const char* filename, const unsigned char* data, size_t size, TextureImage& image);
+
+// Create a texture and upload every level of a parsed image. pixels is the
+// payload start, or an offset into the bound GL_PIXEL_UNPACK_BUFFER.
+// Returns 0 if the driver can't take the format.
+GLuint UploadTextureImage(const TextureImage& image, const unsigned char* pixels);
 
-// Texture class
+// Load an uncompressed 24- or 32-bit BMP into a new texture. The file is
+// memory-mapped and its rows are handed to GL as BGR(A) without a copy.
+// Returns 0 on failure.
+GLuint LoadBitmap(const char* filename, int* width = nullptr, int* height = nullptr);
+
+// Load a DDS file written by ballquest_texconv (DXT1 or 32-bit BGRA) and
+// upload every mip level it holds, straight from the mapping. Returns 0 on
+// failure.
+GLuint LoadDds(const char* filename, int* width = nullptr, int* height = nullptr);
+
+// Texture class. Files ending in .dds go through LoadDds, anything else
+// through LoadBitmap. Textures are shared through a cache keyed by the file's
+// canonical path, so loading the same file again only bumps a reference
+// count; the GL texture is deleted with its last CTexture.
 class CTexture {
 public:
     CTexture();
     ~CTexture();
 
+    CTexture(const CTexture&) = delete;
+    CTexture& operator=(const CTexture&) = delete;
+
     bool LoadTexture(const char* filename);
     void BindTexture();
     void UnbindTexture();
 
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    bool IsLoaded() const { return m_textureID != 0; }
+    GLuint GetID() const { return m_textureID; }
+
+    // Cache access for loaders that upload textures themselves (AssetLoader)
+    static std::string CacheKey(const char* filename);
+    bool Acquire(const std::string& key);   // false if key isn't resident
+    void Adopt(const std::string& key, GLuint id, int width, int height);
+
 private:
-    GLuint m_textureID;
-    int m_width;
-    int m_height;
-    unsigned char* m_imageData;
+    void Release();
+
+    GLuint      m_textureID;
+    int         m_width;
+    int         m_height;
+    std::string m_key;       // Cache entry, empty when nothing is loaded
 };
 
-#endif // TEXTURE_H 
\ No newline at end of file
+#endif // TEXTURE_H
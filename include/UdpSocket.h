@@ -0,0 +1,39 @@
+#ifndef UDPSOCKET_H
+#define UDPSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+
+// Non-blocking IPv4 datagram socket for the server and its clients
+class UdpSocket {
+public:
+    UdpSocket();
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // Bind to port on every interface (0: any free port). bufferBytes
+    // raises the kernel send and receive buffers, so bursts of snapshots
+    // or inputs aren't dropped between drains.
+    bool Open(uint16_t port, int bufferBytes = 1 << 20);
+    void Close();
+    bool IsOpen() const { return m_fd >= 0; }
+
+    bool Send(const sockaddr_in& to, const void* data, size_t size);
+
+    // Next datagram, or -1 when none is waiting
+    int  Receive(void* buffer, size_t capacity, sockaddr_in* from);
+
+    // Block until a datagram arrives or timeoutMs passes
+    bool Wait(int timeoutMs);
+
+private:
+    int m_fd;
+};
+
+// "host" or "host:port" (dotted IPv4 or a name) into an address
+bool ResolveAddress(const char* host, uint16_t defaultPort, sockaddr_in& out);
+
+#endif // UDPSOCKET_H
@@ -3,7 +3,7 @@
 
 #include <string>
 #include <iostream>
-#include <GL/glew.h>
+#include <GL/gl.h>   // Shader entry points need GL_GLEXT_PROTOTYPES
 
 // Vertex shader for basic rendering
 const char* vertexShaderSource = R"(
@@ -80,6 +80,64 @@ const char* rainbowFragmentShaderSource = R"(
     }
 )";
 
+// Instanced ball vertex shader: a unit sphere scaled and moved per instance
+const char* ballVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (location = 2) in vec4 aInstance;   // xyz = center, w = radius
+    layout (location = 3) in vec3 aColor;
+    
+    uniform mat4 view;
+    uniform mat4 projection;
+    
+    out vec3 Normal;
+    out vec3 FragPos;
+    out vec3 Color;
+    
+    void main() {
+        FragPos = aInstance.xyz + aPos * aInstance.w;
+        Normal = aNormal;
+        Color = aColor;
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
+)";
+
+// Instanced ball fragment shader, same lighting as fragmentShaderSource
+const char* ballFragmentShaderSource = R"(
+    #version 330 core
+    in vec3 Normal;
+    in vec3 FragPos;
+    in vec3 Color;
+    
+    uniform vec3 lightPos;
+    uniform vec3 viewPos;
+    
+    out vec4 FragColor;
+    
+    void main() {
+        // Ambient light
+        float ambientStrength = 0.2;
+        vec3 ambient = ambientStrength * vec3(1.0);
+        
+        // Diffuse light
+        vec3 norm = normalize(Normal);
+        vec3 lightDir = normalize(lightPos - FragPos);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * vec3(1.0);
+        
+        // Specular light
+        float specularStrength = 0.5;
+        vec3 viewDir = normalize(viewPos - FragPos);
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+        vec3 specular = specularStrength * spec * vec3(1.0);
+        
+        vec3 result = (ambient + diffuse + specular) * Color;
+        FragColor = vec4(result, 1.0);
+    }
+)";
+
 // Shader compilation and program creation functions
 GLuint createShader(const char* source, GLenum type) {
     GLuint shader = glCreateShader(type);
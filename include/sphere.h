@@ -2,14 +2,13 @@
 #define SPHERE_H
 
 #include <vector>
-#include <GL/glew.h>
-#include <glm/glm.hpp>
+#include <GL/gl.h>   // Buffer and VAO entry points need GL_GLEXT_PROTOTYPES
 #include <cmath>
 
 class Sphere {
 public:
     Sphere(float radius = 1.0f, int sectors = 20, int stacks = 20) {
-        generateVertices(radius, sectors, stacks);
+        generateMesh(radius, sectors, stacks, vertices, indices);
         setupBuffers();
     }
 
@@ -25,12 +24,21 @@ public:
         glBindVertexArray(0);
     }
 
-private:
-    GLuint VAO, VBO, EBO;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    // Draw one copy per instance; per-instance attributes must already be
+    // attached to vertexArray() with a divisor of 1
+    void drawInstanced(GLsizei instances) const {
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, instances);
+        glBindVertexArray(0);
+    }
 
-    void generateVertices(float radius, int sectors, int stacks) {
+    GLuint vertexArray() const { return VAO; }
+    size_t triangleCount() const { return indices.size() / 3; }
+
+    // Interleaved position/normal vertices and triangle indices, appended
+    // to the vectors. Needs no GL, so the benchmarks can run it headless.
+    static void generateMesh(float radius, int sectors, int stacks,
+                             std::vector<float>& vertices, std::vector<unsigned int>& indices) {
         float sectorStep = 2 * M_PI / sectors;
         float stackStep = M_PI / stacks;
 
@@ -81,6 +89,11 @@ private:
         }
     }
 
+private:
+    GLuint VAO, VBO, EBO;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
     void setupBuffers() {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
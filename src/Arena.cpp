@@ -0,0 +1,194 @@
+#include "../include/Arena.h"
+#include "../include/RenderQueue.h"
+#include "../include/Frustum.h"
+#include <algorithm>
+#include <vector>
+
+struct ArenaVertex {
+    float x, y, z;
+    float nx, ny, nz;
+    float u, v;
+};
+
+// Append a tessellated quad spanning origin + s*edgeU + t*edgeV for s, t
+// in [0, 1], with texture coordinates scaled by texU/texV
+static void AppendFace(std::vector<ArenaVertex>& vertices, std::vector<GLuint>& indices,
+                       const float origin[3], const float edgeU[3], const float edgeV[3],
+                       const float normal[3], float texU, float texV, int tessellation) {
+    GLuint base = static_cast<GLuint>(vertices.size());
+    for (int j = 0; j <= tessellation; ++j) {
+        float t = float(j) / tessellation;
+        for (int i = 0; i <= tessellation; ++i) {
+            float s = float(i) / tessellation;
+            vertices.push_back({
+                origin[0] + edgeU[0] * s + edgeV[0] * t,
+                origin[1] + edgeU[1] * s + edgeV[1] * t,
+                origin[2] + edgeU[2] * s + edgeV[2] * t,
+                normal[0], normal[1], normal[2],
+                texU * s, texV * t
+            });
+        }
+    }
+
+    GLuint row = tessellation + 1;
+    for (int j = 0; j < tessellation; ++j) {
+        for (int i = 0; i < tessellation; ++i) {
+            GLuint k = base + j * row + i;
+            indices.push_back(k);
+            indices.push_back(k + 1);
+            indices.push_back(k + row + 1);
+            indices.push_back(k);
+            indices.push_back(k + row + 1);
+            indices.push_back(k + row);
+        }
+    }
+}
+
+Arena::Arena() : m_vertexBuffer(0), m_indexBuffer(0), m_faces(), m_visibleWalls(0) {
+}
+
+Arena::~Arena() {
+    if (m_vertexBuffer != 0) {
+        glDeleteBuffers(1, &m_vertexBuffer);
+        glDeleteBuffers(1, &m_indexBuffer);
+    }
+}
+
+void Arena::Init(float size, float groundY, float wallHeight, int tessellation) {
+    std::vector<ArenaVertex> vertices;
+    std::vector<GLuint> indices;
+
+    const float span = 2.0f * size;
+    const float height = wallHeight - groundY;
+
+    // Index range and bounding box of each face as it is appended
+    int face = 0;
+    auto addFace = [&](const float origin[3], const float edgeU[3], const float edgeV[3],
+                       const float normal[3], float texU, float texV) {
+        Face& f = m_faces[face++];
+        f.firstIndex = static_cast<GLsizei>(indices.size());
+        AppendFace(vertices, indices, origin, edgeU, edgeV, normal, texU, texV, tessellation);
+        f.indexCount = static_cast<GLsizei>(indices.size()) - f.firstIndex;
+        for (int axis = 0; axis < 3; ++axis) {
+            float far = origin[axis] + edgeU[axis] + edgeV[axis];
+            f.minCorner[axis] = std::min(origin[axis], far);
+            f.maxCorner[axis] = std::max(origin[axis], far);
+        }
+    };
+
+    // Ground
+    {
+        const float origin[3] = { -size, groundY, -size };
+        const float edgeU[3]  = { span, 0.0f, 0.0f };
+        const float edgeV[3]  = { 0.0f, 0.0f, span };
+        const float normal[3] = { 0.0f, 1.0f, 0.0f };
+        addFace(origin, edgeU, edgeV, normal, 1.0f, 1.0f);
+    }
+
+    // Walls, texture repeated four times along their length
+    const float up[3] = { 0.0f, height, 0.0f };
+    {
+        const float origin[3] = { -size, groundY, -size };
+        const float edgeU[3]  = { span, 0.0f, 0.0f };
+        const float normal[3] = { 0.0f, 0.0f, 1.0f };
+        addFace(origin, edgeU, up, normal, 4.0f, 1.0f);
+    }
+    {
+        const float origin[3] = { -size, groundY, size };
+        const float edgeU[3]  = { span, 0.0f, 0.0f };
+        const float normal[3] = { 0.0f, 0.0f, -1.0f };
+        addFace(origin, edgeU, up, normal, 4.0f, 1.0f);
+    }
+    {
+        const float origin[3] = { size, groundY, -size };
+        const float edgeU[3]  = { 0.0f, 0.0f, span };
+        const float normal[3] = { -1.0f, 0.0f, 0.0f };
+        addFace(origin, edgeU, up, normal, 4.0f, 1.0f);
+    }
+    {
+        const float origin[3] = { -size, groundY, -size };
+        const float edgeU[3]  = { 0.0f, 0.0f, span };
+        const float normal[3] = { 1.0f, 0.0f, 0.0f };
+        addFace(origin, edgeU, up, normal, 4.0f, 1.0f);
+    }
+
+    if (m_vertexBuffer == 0) {
+        glGenBuffers(1, &m_vertexBuffer);
+        glGenBuffers(1, &m_indexBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(ArenaVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Arena::Submit(RenderQueue& queue, const CTexture& wallTexture, const Frustum& frustum) {
+    const Face& groundFace = m_faces[FACE_GROUND];
+    if (frustum.TestBox(groundFace.minCorner, groundFace.maxCorner)) {
+        RenderState ground = { 0, 0, false, true, true };
+        queue.Submit(PASS_OPAQUE, ground, PHASE_ARENA, &Arena::DrawGround, this);
+    }
+
+    m_visibleWalls = 0;
+    for (int wall = FACE_GROUND + 1; wall < FACE_COUNT; ++wall) {
+        if (frustum.TestBox(m_faces[wall].minCorner, m_faces[wall].maxCorner)) {
+            m_visibleWalls |= 1u << wall;
+        }
+    }
+    if (m_visibleWalls) {
+        RenderState walls = { 0, wallTexture.GetID(), false, true, true };
+        queue.Submit(PASS_OPAQUE, walls, PHASE_ARENA, &Arena::DrawWalls, this);
+    }
+}
+
+int Arena::DrawGround(void* context) {
+    Arena* arena = static_cast<Arena*>(context);
+    const Face& ground = arena->m_faces[FACE_GROUND];
+    arena->DrawRange(ground.firstIndex, ground.indexCount);
+    return 1;
+}
+
+int Arena::DrawWalls(void* context) {
+    // Adjacent visible walls are contiguous in the index buffer, so each
+    // run of them is one draw
+    Arena* arena = static_cast<Arena*>(context);
+    int draws = 0;
+    int wall = FACE_GROUND + 1;
+    while (wall < FACE_COUNT) {
+        if (!(arena->m_visibleWalls & (1u << wall))) {
+            ++wall;
+            continue;
+        }
+        GLsizei first = arena->m_faces[wall].firstIndex;
+        GLsizei count = 0;
+        while (wall < FACE_COUNT && (arena->m_visibleWalls & (1u << wall))) {
+            count += arena->m_faces[wall].indexCount;
+            ++wall;
+        }
+        arena->DrawRange(first, count);
+        ++draws;
+    }
+    return draws;
+}
+
+void Arena::DrawRange(GLsizei firstIndex, GLsizei count) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(ArenaVertex), (void*)0);
+    glNormalPointer(GL_FLOAT, sizeof(ArenaVertex), (void*)(3 * sizeof(float)));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(ArenaVertex), (void*)(6 * sizeof(float)));
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)));
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,263 @@
+#include "../include/AssetLoader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+
+AssetLoader::AssetLoader()
+    : m_outstanding(0), m_stop(false), m_pbo(0), m_pboCapacity(0), m_pboOwner(nullptr),
+      m_usePbo(-1) {
+}
+
+AssetLoader::~AssetLoader() {
+    StopWorker();
+    for (Job* job : m_pending) {
+        ReleaseFile(*job);
+        delete job;
+    }
+}
+
+void AssetLoader::StopWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void AssetLoader::Shutdown() {
+    // The worker may still be writing into the mapped buffer
+    StopWorker();
+    if (m_pbo != 0) {
+        glDeleteBuffers(1, &m_pbo);
+        m_pbo = 0;
+        m_pboCapacity = 0;
+    }
+    m_pboOwner = nullptr;
+}
+
+void AssetLoader::LoadTexture(CTexture* texture, const char* path, const char* fallback) {
+    // Already resident, or already on its way
+    if (texture->Acquire(CTexture::CacheKey(path))) return;
+    for (Job* job : m_pending) {
+        if (job->paths[0] == path) {
+            job->textures.push_back(texture);
+            return;
+        }
+    }
+
+    Job* job = new Job();
+    job->textures.push_back(texture);
+    job->paths.push_back(path);
+    if (fallback) job->paths.push_back(fallback);
+    job->next = 0;
+    job->data = nullptr;
+    job->dataSize = 0;
+    job->staging = nullptr;
+    job->ok = false;
+    m_pending.push_back(job);
+    m_outstanding.fetch_add(1, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.push_back(job);
+        if (!m_worker.joinable()) {
+            m_worker = std::thread(&AssetLoader::WorkerMain, this);
+        }
+    }
+    m_wake.notify_one();
+}
+
+void AssetLoader::ReleaseFile(Job& job) {
+    if (job.data) {
+        UnmapTextureFile(job.data, job.dataSize);
+        job.data = nullptr;
+    }
+}
+
+void AssetLoader::WorkerMain() {
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_queued.empty(); });
+            if (m_stop) return;
+            job = m_queued.front();
+            m_queued.pop_front();
+        }
+
+        if (job->staging) {
+            // Back with a mapped PBO: the page faults and disk reads of the
+            // payload happen here, off the GL thread
+            memcpy(job->staging, job->data + job->image.payloadOffset, job->image.payloadSize);
+            ReleaseFile(*job);
+        }
+        else {
+            // Resumes after the path whose upload failed, if it is back here
+            while (job->next < job->paths.size()) {
+                const std::string& path = job->paths[job->next++];
+                job->data = MapTextureFile(path.c_str(), job->dataSize);
+                if (!job->data) continue;
+                if (ParseTextureFile(path.c_str(), job->data, job->dataSize, job->image)) {
+                    job->key = CTexture::CacheKey(path.c_str());
+                    job->ok = true;
+                    break;
+                }
+                ReleaseFile(*job);
+            }
+            if (job->ok) {
+                // Start reading the payload in while the job waits for GL
+                madvise(const_cast<unsigned char*>(job->data), job->dataSize, MADV_WILLNEED);
+            }
+            else {
+                std::cerr << "Error: Couldn't load " << job->paths[0] << std::endl;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.push_back(job);
+        }
+        m_done.notify_all();
+    }
+}
+
+void AssetLoader::Poll() {
+    if (IsIdle()) return;
+
+    std::deque<Job*> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        finished.swap(m_finished);
+    }
+
+    for (Job* job : finished) {
+        if (job->ok && !job->staging) {
+            // Pixel unpack buffers with glMapBufferRange need OpenGL 3.0
+            if (m_usePbo < 0) {
+                int major = 0;
+                const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+                m_usePbo = version && sscanf(version, "%d", &major) == 1 && major >= 3;
+            }
+            if (m_usePbo) {
+                m_staging.push_back(job);
+                continue;
+            }
+        }
+
+        Complete(job);
+    }
+
+    StartStaging();
+}
+
+// Upload a job the worker is done with, then retire it, or send it back to
+// the worker for the next path if the driver can't take this file
+void AssetLoader::Complete(Job* job) {
+    if (job->ok && !Upload(*job) && job->next < job->paths.size()) {
+        std::cerr << "Error: Couldn't upload " << job->key << ", trying "
+                  << job->paths[job->next] << std::endl;
+        job->ok = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued.push_back(job);
+        }
+        m_wake.notify_one();
+        return;
+    }
+    m_pending.erase(std::find(m_pending.begin(), m_pending.end(), job));
+    delete job;
+    m_outstanding.fetch_sub(1, std::memory_order_release);
+}
+
+// Map the PBO for the next parsed job and send it back to the worker to
+// fill. One job holds the buffer at a time; mapping it again with
+// GL_MAP_INVALIDATE_BUFFER_BIT orphans the storage the last upload still
+// reads from, so this doesn't wait for GL.
+void AssetLoader::StartStaging() {
+    while (!m_pboOwner && !m_staging.empty()) {
+        Job* job = m_staging.front();
+        m_staging.pop_front();
+        if (m_usePbo) {
+            if (m_pbo == 0) {
+                glGenBuffers(1, &m_pbo);
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+            GLsizeiptr size = static_cast<GLsizeiptr>(job->image.payloadSize);
+            if (size > m_pboCapacity) {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+                m_pboCapacity = size;
+            }
+            job->staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        if (!job->staging) {
+            // No buffer to stage through; upload from the file mapping
+            m_usePbo = 0;
+            Complete(job);
+            continue;
+        }
+        m_pboOwner = job;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued.push_back(job);
+        }
+        m_wake.notify_one();
+    }
+}
+
+bool AssetLoader::Upload(Job& job) {
+    CTexture* first = job.textures[0];
+    bool staged = job.staging != nullptr;
+    bool intact = true;
+    if (staged) {
+        // The worker has copied the payload in; unmapping hands it to GL
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+        intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        job.staging = nullptr;
+        m_pboOwner = nullptr;
+    }
+
+    // Another path may have made the file resident in the meantime
+    bool resident = first->Acquire(job.key);
+    if (!resident && intact) {
+        // From the bound PBO, or straight from the file mapping
+        const unsigned char* pixels = staged ? nullptr : job.data + job.image.payloadOffset;
+        GLuint id = UploadTextureImage(job.image, pixels);
+        if (id != 0) {
+            first->Adopt(job.key, id, job.image.width, job.image.height);
+            resident = true;
+        }
+    }
+    if (staged) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    ReleaseFile(job);
+
+    if (!resident) {
+        if (job.next >= job.paths.size()) {
+            std::cerr << "Error: Couldn't upload " << job.key << std::endl;
+        }
+        return false;
+    }
+    for (size_t i = 1; i < job.textures.size(); ++i) {
+        job.textures[i]->Acquire(job.key);
+    }
+    return true;
+}
+
+void AssetLoader::Wait() {
+    while (!IsIdle()) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this] { return !m_finished.empty(); });
+        }
+        Poll();
+    }
+}
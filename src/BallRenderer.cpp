@@ -0,0 +1,115 @@
+#include "../include/BallRenderer.h"
+#include "../include/RenderQueue.h"
+#include "../include/sphere.h"
+#include "../include/shaders.h"
+#include <cstdio>
+#include <cstddef>
+
+BallRenderer::BallRenderer()
+    : m_sphere(nullptr), m_program(0), m_instanceBuffer(0), m_instanceCapacity(0),
+      m_viewLoc(-1), m_projectionLoc(-1), m_lightPosLoc(-1), m_viewPosLoc(-1) {
+}
+
+BallRenderer::~BallRenderer() {
+    delete m_sphere;
+    if (m_instanceBuffer != 0) {
+        glDeleteBuffers(1, &m_instanceBuffer);
+    }
+    if (m_program != 0) {
+        glDeleteProgram(m_program);
+    }
+}
+
+bool BallRenderer::Init() {
+    // Instanced arrays and #version 330 shaders need OpenGL 3.3
+    int major = 0, minor = 0;
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+        major < 3 || (major == 3 && minor < 3)) {
+        std::cerr << "Instanced ball rendering unavailable, using gluSphere" << std::endl;
+        return false;
+    }
+
+    GLuint program = createShaderProgram(ballVertexShaderSource, ballFragmentShaderSource);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        return false;
+    }
+    m_program = program;
+
+    m_viewLoc       = glGetUniformLocation(m_program, "view");
+    m_projectionLoc = glGetUniformLocation(m_program, "projection");
+    m_lightPosLoc   = glGetUniformLocation(m_program, "lightPos");
+    m_viewPosLoc    = glGetUniformLocation(m_program, "viewPos");
+
+    // Unit sphere, scaled per instance by the fruit size. Kept coarse: with
+    // tens of thousands of instances the vertex stage dominates on llvmpipe
+    m_sphere = new Sphere(1.0f, 12, 8);
+
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindVertexArray(m_sphere->vertexArray());
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+    // Center and radius
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BallInstance),
+                          (void*)offsetof(BallInstance, x));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    // Color
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BallInstance),
+                          (void*)offsetof(BallInstance, r));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return true;
+}
+
+void BallRenderer::Submit(RenderQueue& queue, FruitPool& mainFruits, FruitPool& blackFruits,
+                          const Vector3& eye, float alpha) {
+    m_instances.clear();
+    mainFruits.AppendInstances(m_instances, alpha);
+    blackFruits.AppendInstances(m_instances, alpha);
+    if (m_instances.empty()) return;
+
+    // Lit in the shader; fixed-function lighting is ignored, so leave it on
+    // like the arena's to save a toggle
+    m_eye = eye;
+    RenderState state = { m_program, 0, false, true, true };
+    queue.Submit(PASS_OPAQUE, state, PHASE_BALLS, &BallRenderer::DrawQueued, this);
+}
+
+int BallRenderer::DrawQueued(void* context) {
+    BallRenderer* renderer = static_cast<BallRenderer*>(context);
+    renderer->Draw();
+    return 1;
+}
+
+void BallRenderer::Draw() {
+
+    // Orphan the previous frame's storage so the upload never waits on the GPU
+    GLsizeiptr bytes = m_instances.size() * sizeof(BallInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (bytes > m_instanceCapacity) {
+        m_instanceCapacity = bytes * 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLfloat view[16], projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, view);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+    glUniformMatrix4fv(m_viewLoc, 1, GL_FALSE, view);
+    glUniformMatrix4fv(m_projectionLoc, 1, GL_FALSE, projection);
+    glUniform3f(m_lightPosLoc, 0.0f, 10.0f, 0.0f);
+    glUniform3f(m_viewPosLoc, m_eye.x, m_eye.y, m_eye.z);
+
+    m_sphere->drawInstanced(static_cast<GLsizei>(m_instances.size()));
+}
@@ -19,4 +19,9 @@ void CCamera::Look() {
     gluLookAt(m_vPosition.x, m_vPosition.y, m_vPosition.z,
               m_vView.x, m_vView.y, m_vView.z,
               m_vUpVector.x, m_vUpVector.y, m_vUpVector.z);
+
+    GLfloat view[16], projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, view);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    m_frustum.Extract(projection, view);
 } 
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "../include/Collision.h"
+#include "../include/GameWorld.h"
+#include "../include/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+CatchVolume MakeCatchVolume(const Vector3& position, const Vector3& view) {
+    Vector3 viewDir = view - position;
+    viewDir.Normalize();
+
+    CatchVolume volume;
+    volume.ringCenter  = position + (viewDir * 2.0f);
+    volume.ringNormal  = viewDir;
+    volume.ringOuterSq = RING_RADIUS * RING_RADIUS;
+    volume.ringInnerSq = (RING_RADIUS * 0.8f) * (RING_RADIUS * 0.8f);
+    volume.player      = position;
+    volume.catchDistSq = CATCH_DISTANCE * CATCH_DISTANCE;
+    volume.catchTop    = position.y + 2.0f;
+    return volume;
+}
+
+// Scalar form of the kernel below, for single fruits. A fruit moves
+// straight down from prevY to y during a step, clipped at the floor where
+// it landed; both tests are exact for that segment however long it is.
+//
+// Ring: the signed distance to the ring plane is linear in height, so the
+// crossing height follows from its values at the two ends, and the fruit
+// counts if that point lies in the annulus. The end of the segment counts
+// as the far side when it sits exactly on the plane, so a fruit stopping
+// there is caught once, not on both steps.
+//
+// Direct catch: the segment meets the catch cylinder when the fruit is
+// within reach horizontally and its lowest point is below the top.
+static inline bool TestCatch(const FruitPool& fruits, const CatchVolume& volume, int i) {
+    const float x  = fruits.X()[i];
+    const float z  = fruits.Z()[i];
+    const float y0 = fruits.PrevY()[i];
+    const float y1 = std::max(fruits.Y()[i], FruitPool::FLOOR_HEIGHT);
+
+    float dx = x - volume.ringCenter.x;
+    float dz = z - volume.ringCenter.z;
+    float dy0 = y0 - volume.ringCenter.y;
+    float dy1 = y1 - volume.ringCenter.y;
+    float flat = dx * volume.ringNormal.x + dz * volume.ringNormal.z;
+    float along0 = flat + dy0 * volume.ringNormal.y;
+    float along1 = flat + dy1 * volume.ringNormal.y;
+
+    bool ring = false;
+    if ((along0 > 0.0f) != (along1 > 0.0f)) {
+        float t = along0 / (along0 - along1);
+        float dy = dy0 + t * (dy1 - dy0);
+        float axisSq = dx * dx + dy * dy + dz * dz;   // The point is on the plane
+        ring = axisSq <= volume.ringOuterSq && axisSq >= volume.ringInnerSq;
+    }
+
+    float ex = x - volume.player.x;
+    float ez = z - volume.player.z;
+    bool caught = (ex * ex + ez * ez < volume.catchDistSq) && (y1 < volume.catchTop);
+
+    return ring || caught;
+}
+
+// Append the set lanes of a hit mask as fruit indices
+static inline void EmitHits(unsigned bits, int base, std::vector<int>& hits) {
+    while (bits) {
+        hits.push_back(base + __builtin_ctz(bits));
+        bits &= bits - 1;
+    }
+}
+
+void FindCatches(const FruitPool& fruits, const CatchVolume& volume, std::vector<int>& hits) {
+    const float* xs    = fruits.X();
+    const float* ys    = fruits.Y();
+    const float* zs    = fruits.Z();
+    const float* prevs = fruits.PrevY();
+    const uint8_t* mask = reinterpret_cast<const uint8_t*>(fruits.AllocatedMask());
+    const int padded = (fruits.Size() + FruitPool::FRUIT_LANES - 1) / FruitPool::FRUIT_LANES * FruitPool::FRUIT_LANES;
+
+#if defined(__AVX2__)
+    const __m256 cx = _mm256_set1_ps(volume.ringCenter.x);
+    const __m256 cy = _mm256_set1_ps(volume.ringCenter.y);
+    const __m256 cz = _mm256_set1_ps(volume.ringCenter.z);
+    const __m256 nx = _mm256_set1_ps(volume.ringNormal.x);
+    const __m256 ny = _mm256_set1_ps(volume.ringNormal.y);
+    const __m256 nz = _mm256_set1_ps(volume.ringNormal.z);
+    const __m256 outerSq = _mm256_set1_ps(volume.ringOuterSq);
+    const __m256 innerSq = _mm256_set1_ps(volume.ringInnerSq);
+    const __m256 px = _mm256_set1_ps(volume.player.x);
+    const __m256 pz = _mm256_set1_ps(volume.player.z);
+    const __m256 catchSq  = _mm256_set1_ps(volume.catchDistSq);
+    const __m256 catchTop = _mm256_set1_ps(volume.catchTop);
+    const __m256 floor = _mm256_set1_ps(FruitPool::FLOOR_HEIGHT);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (int i = 0; i < padded; i += 8) {
+        unsigned live = mask[i >> 3];
+        if (!live) continue;
+
+        __m256 x  = _mm256_loadu_ps(&xs[i]);
+        __m256 z  = _mm256_loadu_ps(&zs[i]);
+        __m256 y0 = _mm256_loadu_ps(&prevs[i]);
+        __m256 y1 = _mm256_max_ps(_mm256_loadu_ps(&ys[i]), floor);
+
+        // Ring: signed plane distance at both ends of the step's segment,
+        // then the annulus test at the height where it changes side
+        __m256 dx  = _mm256_sub_ps(x, cx);
+        __m256 dz  = _mm256_sub_ps(z, cz);
+        __m256 dy0 = _mm256_sub_ps(y0, cy);
+        __m256 dy1 = _mm256_sub_ps(y1, cy);
+        __m256 flat   = _mm256_add_ps(_mm256_mul_ps(dx, nx), _mm256_mul_ps(dz, nz));
+        __m256 along0 = _mm256_add_ps(flat, _mm256_mul_ps(dy0, ny));
+        __m256 along1 = _mm256_add_ps(flat, _mm256_mul_ps(dy1, ny));
+        __m256 ring = _mm256_xor_ps(_mm256_cmp_ps(along0, zero, _CMP_GT_OQ),
+                                    _mm256_cmp_ps(along1, zero, _CMP_GT_OQ));
+
+        // Lanes that didn't cross may divide by zero; they are masked off
+        __m256 t  = _mm256_div_ps(along0, _mm256_sub_ps(along0, along1));
+        __m256 dy = _mm256_add_ps(dy0, _mm256_mul_ps(t, _mm256_sub_ps(dy1, dy0)));
+        __m256 axisSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        ring = _mm256_and_ps(ring, _mm256_cmp_ps(axisSq, outerSq, _CMP_LE_OQ));
+        ring = _mm256_and_ps(ring, _mm256_cmp_ps(axisSq, innerSq, _CMP_GE_OQ));
+
+        // Direct catch: horizontal distance to the player, lowest point
+        // of the segment below the top of the catch cylinder
+        __m256 ex = _mm256_sub_ps(x, px);
+        __m256 ez = _mm256_sub_ps(z, pz);
+        __m256 playerSq = _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ez, ez));
+        __m256 caught = _mm256_and_ps(_mm256_cmp_ps(playerSq, catchSq, _CMP_LT_OQ),
+                                      _mm256_cmp_ps(y1, catchTop, _CMP_LT_OQ));
+
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_or_ps(ring, caught))) & live;
+        EmitHits(bits, i, hits);
+    }
+#elif defined(__SSE2__)
+    const __m128 cx = _mm_set1_ps(volume.ringCenter.x);
+    const __m128 cy = _mm_set1_ps(volume.ringCenter.y);
+    const __m128 cz = _mm_set1_ps(volume.ringCenter.z);
+    const __m128 nx = _mm_set1_ps(volume.ringNormal.x);
+    const __m128 ny = _mm_set1_ps(volume.ringNormal.y);
+    const __m128 nz = _mm_set1_ps(volume.ringNormal.z);
+    const __m128 outerSq = _mm_set1_ps(volume.ringOuterSq);
+    const __m128 innerSq = _mm_set1_ps(volume.ringInnerSq);
+    const __m128 px = _mm_set1_ps(volume.player.x);
+    const __m128 pz = _mm_set1_ps(volume.player.z);
+    const __m128 catchSq  = _mm_set1_ps(volume.catchDistSq);
+    const __m128 catchTop = _mm_set1_ps(volume.catchTop);
+    const __m128 floor = _mm_set1_ps(FruitPool::FLOOR_HEIGHT);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int i = 0; i < padded; i += 4) {
+        unsigned live = (mask[i >> 3] >> (i & 7)) & 0xFu;
+        if (!live) continue;
+
+        __m128 x  = _mm_loadu_ps(&xs[i]);
+        __m128 z  = _mm_loadu_ps(&zs[i]);
+        __m128 y0 = _mm_loadu_ps(&prevs[i]);
+        __m128 y1 = _mm_max_ps(_mm_loadu_ps(&ys[i]), floor);
+
+        // Ring: signed plane distance at both ends of the step's segment,
+        // then the annulus test at the height where it changes side
+        __m128 dx  = _mm_sub_ps(x, cx);
+        __m128 dz  = _mm_sub_ps(z, cz);
+        __m128 dy0 = _mm_sub_ps(y0, cy);
+        __m128 dy1 = _mm_sub_ps(y1, cy);
+        __m128 flat   = _mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dz, nz));
+        __m128 along0 = _mm_add_ps(flat, _mm_mul_ps(dy0, ny));
+        __m128 along1 = _mm_add_ps(flat, _mm_mul_ps(dy1, ny));
+        __m128 ring = _mm_xor_ps(_mm_cmpgt_ps(along0, zero), _mm_cmpgt_ps(along1, zero));
+
+        // Lanes that didn't cross may divide by zero; they are masked off
+        __m128 t  = _mm_div_ps(along0, _mm_sub_ps(along0, along1));
+        __m128 dy = _mm_add_ps(dy0, _mm_mul_ps(t, _mm_sub_ps(dy1, dy0)));
+        __m128 axisSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        ring = _mm_and_ps(ring, _mm_cmple_ps(axisSq, outerSq));
+        ring = _mm_and_ps(ring, _mm_cmpge_ps(axisSq, innerSq));
+
+        // Direct catch: horizontal distance to the player, lowest point
+        // of the segment below the top of the catch cylinder
+        __m128 ex = _mm_sub_ps(x, px);
+        __m128 ez = _mm_sub_ps(z, pz);
+        __m128 playerSq = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ez, ez));
+        __m128 caught = _mm_and_ps(_mm_cmplt_ps(playerSq, catchSq), _mm_cmplt_ps(y1, catchTop));
+
+        unsigned bits = static_cast<unsigned>(_mm_movemask_ps(_mm_or_ps(ring, caught))) & live;
+        EmitHits(bits, i, hits);
+    }
+#else
+    for (int i = 0; i < padded; ++i) {
+        if (((mask[i >> 3] >> (i & 7)) & 1u) && TestCatch(fruits, volume, i)) {
+            hits.push_back(i);
+        }
+    }
+#endif
+}
+
+// Candidates per parallel chunk
+static const int QUERY_GRAIN = 8192;
+
+void QueryCatches(const FruitPool& fruits, const CatchVolume& volume,
+                  std::vector<int>& candidates, std::vector<int>& hits, JobSystem* jobs) {
+    // Fruits fall straight down, so only their XZ position decides whether
+    // they can reach the ring or the catch radius this step. The ring test
+    // is made at the crossing point, which is within the ring radius of the
+    // center, so however far a fruit fell its column has to be too.
+    float ringReach = std::sqrt(volume.ringOuterSq);
+    float catchReach = std::sqrt(volume.catchDistSq);
+    float minX = std::min(volume.ringCenter.x - ringReach, volume.player.x - catchReach);
+    float maxX = std::max(volume.ringCenter.x + ringReach, volume.player.x + catchReach);
+    float minZ = std::min(volume.ringCenter.z - ringReach, volume.player.z - catchReach);
+    float maxZ = std::max(volume.ringCenter.z + ringReach, volume.player.z + catchReach);
+
+    candidates.clear();
+    fruits.GetGrid().Query(minX, minZ, maxX, maxZ, candidates);
+
+    size_t first = hits.size();
+    if (jobs) {
+        // Strike the misses out in place, then gather what is left in
+        // candidate order, so the hits match the serial loop exactly
+        auto body = [&](int begin, int end) {
+            for (int k = begin; k < end; ++k) {
+                int i = candidates[k];
+                if (!fruits.IsAllocated(i) || !TestCatch(fruits, volume, i)) {
+                    candidates[k] = -1;
+                }
+            }
+        };
+        jobs->ParallelFor(static_cast<int>(candidates.size()), QUERY_GRAIN, body);
+        for (int i : candidates) {
+            if (i >= 0) hits.push_back(i);
+        }
+    }
+    else {
+        for (int i : candidates) {
+            if (fruits.IsAllocated(i) && TestCatch(fruits, volume, i)) {
+                hits.push_back(i);
+            }
+        }
+    }
+    std::sort(hits.begin() + first, hits.end());
+}
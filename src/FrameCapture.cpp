@@ -0,0 +1,328 @@
+#include "../include/FrameCapture.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// PNG writing. Deflate runs in stored (uncompressed) blocks, so there's no
+// compression dependency and the worker keeps up at full frame rate; the
+// files are about the size of the raw pixels.
+
+static uint32_t s_crcTable[256];
+
+static void InitCrcTable() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        s_crcTable[n] = c;
+    }
+}
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = s_crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Append a chunk whose data is already at out[start + 8, end), leaving
+// room for the length and type in front
+static void FinishChunk(std::vector<uint8_t>& out, size_t start, const char type[4]) {
+    uint32_t length = static_cast<uint32_t>(out.size() - start - 8);
+    out[start]     = static_cast<uint8_t>(length >> 24);
+    out[start + 1] = static_cast<uint8_t>(length >> 16);
+    out[start + 2] = static_cast<uint8_t>(length >> 8);
+    out[start + 3] = static_cast<uint8_t>(length);
+    memcpy(&out[start + 4], type, 4);
+    PutBigEndian(out, Crc32(0, &out[start + 4], length + 4));
+}
+
+static size_t BeginChunk(std::vector<uint8_t>& out) {
+    size_t start = out.size();
+    out.resize(start + 8);
+    return start;
+}
+
+// rows: height rows of 1 + width * 3 bytes, each starting with filter 0
+static void EncodePng(const std::vector<uint8_t>& rows, int width, int height, std::vector<uint8_t>& out) {
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.assign(SIGNATURE, SIGNATURE + 8);
+
+    size_t chunk = BeginChunk(out);
+    PutBigEndian(out, width);
+    PutBigEndian(out, height);
+    const uint8_t format[5] = { 8, 2, 0, 0, 0 };   // 8-bit RGB, no interlace
+    out.insert(out.end(), format, format + 5);
+    FinishChunk(out, chunk, "IHDR");
+
+    // zlib stream of stored blocks, at most 65535 bytes each
+    chunk = BeginChunk(out);
+    out.push_back(0x78);
+    out.push_back(0x01);
+    uint32_t a = 1, b = 0;
+    size_t offset = 0;
+    do {
+        size_t block = std::min<size_t>(rows.size() - offset, 65535);
+        bool last = offset + block == rows.size();
+        out.push_back(last ? 1 : 0);
+        out.push_back(static_cast<uint8_t>(block));
+        out.push_back(static_cast<uint8_t>(block >> 8));
+        out.push_back(static_cast<uint8_t>(~block));
+        out.push_back(static_cast<uint8_t>(~block >> 8));
+        out.insert(out.end(), rows.begin() + offset, rows.begin() + offset + block);
+
+        // Adler-32; sums can't overflow in 5552 bytes, so reduce once per run
+        for (size_t i = offset; i < offset + block; ) {
+            size_t run = std::min<size_t>(offset + block - i, 5552);
+            for (size_t end = i + run; i < end; ++i) {
+                a += rows[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        offset += block;
+    } while (offset < rows.size());
+    PutBigEndian(out, (b << 16) | a);
+    FinishChunk(out, chunk, "IDAT");
+
+    chunk = BeginChunk(out);
+    FinishChunk(out, chunk, "IEND");
+}
+
+FrameCapture::FrameCapture()
+    : m_active(false), m_width(0), m_height(0), m_toStdout(false), m_pipe(nullptr),
+      m_next(0), m_stop(false), m_written(0) {
+    for (int slot = 0; slot < RING_SIZE; ++slot) {
+        m_pbo[slot] = 0;
+        m_fence[slot] = nullptr;
+        m_frameOf[slot] = -1;
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    // Without GL; Finish() is what collects frames still in flight
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+bool FrameCapture::Start(const char* target, int width, int height) {
+    m_toStdout = strcmp(target, "-") == 0;
+    if (m_toStdout) {
+        // Keep the real stdout for frames and send the rest to stderr
+        int fd = dup(STDOUT_FILENO);
+        m_pipe = fd >= 0 ? fdopen(fd, "wb") : nullptr;
+        if (!m_pipe) {
+            std::cerr << "Could not capture to stdout" << std::endl;
+            return false;
+        }
+        fflush(stdout);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    else {
+        m_directory = target;
+        mkdir(target, 0755);
+        struct stat info;
+        if (stat(target, &info) != 0 || !S_ISDIR(info.st_mode)) {
+            std::cerr << "Capture directory " << target << " is not usable" << std::endl;
+            return false;
+        }
+        InitCrcTable();
+    }
+
+    m_width = width;
+    m_height = height;
+    glGenBuffers(RING_SIZE, m_pbo);
+    AllocateBuffers();
+
+    for (Frame& frame : m_pool) {
+        frame.pixels.resize(size_t(width) * height * 4);
+        m_free.push_back(&frame);
+    }
+    m_worker = std::thread(&FrameCapture::WorkerMain, this);
+    m_active = true;
+    return true;
+}
+
+void FrameCapture::AllocateBuffers() {
+    GLsizeiptr bytes = GLsizeiptr(m_width) * m_height * 4;
+    for (int slot = 0; slot < RING_SIZE; ++slot) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool FrameCapture::Resize(int width, int height) {
+    if (!m_active) return false;
+    if (width == m_width && height == m_height) return true;
+    if (m_toStdout) {
+        std::cerr << "Raw capture can't change frame size; stopping at "
+                  << m_width << "x" << m_height << std::endl;
+        Finish();
+        return false;
+    }
+
+    // Oldest first, at the size they were read at; the pooled frames take
+    // the new size as they are reused
+    for (int k = 0; k < RING_SIZE; ++k) {
+        Collect((m_next + k) % RING_SIZE);
+    }
+    m_width = width;
+    m_height = height;
+    AllocateBuffers();
+    return true;
+}
+
+void FrameCapture::Capture() {
+    if (!m_active) return;
+
+    // The slot last held the frame RING_SIZE captures ago
+    int slot = m_next % RING_SIZE;
+    Collect(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_frameOf[slot] = m_next++;
+}
+
+void FrameCapture::Collect(int slot) {
+    if (m_frameOf[slot] < 0) return;
+
+    // Long since signaled in steady state; only Finish() can really wait
+    glClientWaitSync(m_fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(m_fence[slot]);
+    m_fence[slot] = nullptr;
+
+    // A free pooled frame, waiting for the worker if it has fallen behind
+    Frame* frame;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_freed.wait(lock, [this] { return !m_free.empty(); });
+        frame = m_free.back();
+        m_free.pop_back();
+    }
+
+    frame->width = m_width;
+    frame->height = m_height;
+    frame->pixels.resize(size_t(m_width) * m_height * 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+    const void* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels) {
+        memcpy(frame->pixels.data(), pixels, frame->pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    frame->index = m_frameOf[slot];
+    m_frameOf[slot] = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pixels) m_queued.push_back(frame);
+        else        m_free.push_back(frame);
+    }
+    m_wake.notify_one();
+}
+
+void FrameCapture::Finish() {
+    if (!m_active) return;
+    m_active = false;
+
+    // Oldest first, so frames reach the worker in order
+    for (int k = 0; k < RING_SIZE; ++k) {
+        Collect((m_next + k) % RING_SIZE);
+    }
+    glDeleteBuffers(RING_SIZE, m_pbo);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_worker.join();
+
+    if (m_pipe) {
+        fclose(m_pipe);
+        m_pipe = nullptr;
+    }
+    std::cerr << "Captured " << m_written << " frames" << std::endl;
+}
+
+void FrameCapture::WorkerMain() {
+    for (;;) {
+        Frame* frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_queued.empty(); });
+            // Drain what's queued before stopping
+            if (m_queued.empty()) return;
+            frame = m_queued.front();
+            m_queued.pop_front();
+        }
+
+        if (WriteFrame(*frame)) {
+            ++m_written;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(frame);
+        }
+        m_freed.notify_one();
+    }
+}
+
+bool FrameCapture::WriteFrame(Frame& frame) {
+    // RGBA bottom-up to RGB top-down, each row led by a PNG filter byte
+    // unless it goes straight to the pipe
+    const size_t lead = m_toStdout ? 0 : 1;
+    const int width = frame.width;
+    const int height = frame.height;
+    const size_t rowBytes = lead + size_t(width) * 3;
+    m_rgb.resize(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = &frame.pixels[size_t(height - 1 - y) * width * 4];
+        uint8_t* dst = &m_rgb[y * rowBytes];
+        if (lead) *dst++ = 0;
+        for (int x = 0; x < width; ++x) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst += 3;
+            src += 4;
+        }
+    }
+
+    if (m_toStdout) {
+        return fwrite(m_rgb.data(), 1, m_rgb.size(), m_pipe) == m_rgb.size();
+    }
+
+    EncodePng(m_rgb, width, height, m_encoded);
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%06d.png", frame.index);
+    std::string path = m_directory + name;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(m_encoded.data(), 1, m_encoded.size(), file) == m_encoded.size();
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,48 @@
+#include "FruitPool.h"
+#include "BallRenderer.h"
+#include <GL/glu.h>
+#include <cmath>
+
+// Shared quadric used by every fruit, created on first draw
+static GLUquadricObj* s_quadric = nullptr;
+
+// Advance a rainbow fruit's timer and return its current color
+static Vector3 RainbowColor(float& time) {
+    time += 0.01f;
+    return Vector3(sin(time * 2.0f) * 0.5f + 0.5f,
+                   sin(time * 2.0f + 2.094f) * 0.5f + 0.5f,
+                   sin(time * 2.0f + 4.189f) * 0.5f + 0.5f);
+}
+
+// Height between the previous and the current step
+static inline float Lerp(float from, float to, float alpha) {
+    return from + (to - from) * alpha;
+}
+
+int FruitPool::Draw(float alpha) {
+    // Initialize the quadric if not already done
+    if (!s_quadric) {
+        s_quadric = gluNewQuadric();
+        gluQuadricDrawStyle(s_quadric, GLU_FILL);
+    }
+
+    for (int i : m_visible) {
+        glPushMatrix();
+        glTranslatef(m_x[i], Lerp(m_prevY[i], m_y[i], alpha), m_z[i]);
+
+        Vector3 color = m_isRainbow[i] ? RainbowColor(m_time[i]) : m_color[i];
+        glColor3f(color.x, color.y, color.z);
+
+        gluSphere(s_quadric, m_size[i], 32, 32);
+        glPopMatrix();
+    }
+    return static_cast<int>(m_visible.size());
+}
+
+void FruitPool::AppendInstances(std::vector<BallInstance>& out, float alpha) {
+    for (int i : m_visible) {
+        Vector3 color = m_isRainbow[i] ? RainbowColor(m_time[i]) : m_color[i];
+        out.push_back({ m_x[i], Lerp(m_prevY[i], m_y[i], alpha), m_z[i], m_size[i],
+                        color.x, color.y, color.z });
+    }
+}
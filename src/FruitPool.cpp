@@ -0,0 +1,469 @@
+#include "../include/FruitPool.h"
+#include "../include/Serialize.h"
+#include "../include/JobSystem.h"
+#include "../include/Frustum.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+FruitPool::FruitPool(FruitType type)
+    : m_type(type), m_capacity(0), m_count(0), m_spawnHalfWidth(25), m_spawnHalfDepth(20), m_culled(0) {
+    SetSpawnArea(m_spawnHalfWidth, m_spawnHalfDepth);
+}
+
+void FruitPool::SetSpawnArea(int halfWidth, int halfDepth) {
+    m_spawnHalfWidth = halfWidth;
+    m_spawnHalfDepth = halfDepth;
+    m_grid.Configure(-halfWidth, -halfDepth, halfWidth, halfDepth, GRID_CELL_SIZE);
+}
+
+void FruitPool::Reserve(int capacity) {
+    int padded = (capacity + FRUIT_LANES - 1) / FRUIT_LANES * FRUIT_LANES;
+    m_capacity = capacity;
+
+    // Padding lanes stay inactive so the kernels never need a tail loop
+    m_x.assign(padded, 0.0f);
+    m_y.assign(padded, 0.0f);
+    m_prevY.assign(padded, 0.0f);
+    m_z.assign(padded, 0.0f);
+    m_speed.assign(padded, 0.0f);
+    m_size.assign(padded, 0.0f);
+    m_active.assign((padded + 63) / 64, 0);
+    m_allocated.assign(m_active.size(), 0);
+    m_free.reserve(capacity);
+
+    m_color.assign(capacity, Vector3());
+    m_points.assign(capacity, 0);
+    m_isRainbow.assign(capacity, 0);
+    m_time.assign(capacity, 0.0f);
+
+    m_spawnIndices.reserve(capacity);
+    m_draws.reserve(size_t(capacity) * 4);
+    m_visible.reserve(capacity);
+    Clear();
+}
+
+void FruitPool::Reset(int count, float baseHeight, float spacing, Random& random, JobSystem* jobs) {
+    if (count > m_capacity) Reserve(count);
+    else Clear();
+
+    // An empty pool hands out slots 0, 1, 2, ...
+    m_spawnIndices.clear();
+    for (int i = 0; i < count; ++i) {
+        m_spawnIndices.push_back(Acquire());
+    }
+    Spawn(m_spawnIndices.data(), count, 0.0f, random, jobs); // Initial game time set to 0.0f
+
+    for (int i = 0; i < count; ++i) {
+        m_y[i] = baseHeight + spacing * i;
+        m_prevY[i] = m_y[i];
+    }
+}
+
+void FruitPool::Clear() {
+    m_count = 0;
+    m_visible.clear();
+    m_culled = 0;
+
+    // Stale slots are zeroed so a fresh round is the same whatever ran before
+    std::fill(m_x.begin(), m_x.end(), 0.0f);
+    std::fill(m_y.begin(), m_y.end(), 0.0f);
+    std::fill(m_prevY.begin(), m_prevY.end(), 0.0f);
+    std::fill(m_z.begin(), m_z.end(), 0.0f);
+    std::fill(m_speed.begin(), m_speed.end(), 0.0f);
+    std::fill(m_size.begin(), m_size.end(), 0.0f);
+    std::fill(m_active.begin(), m_active.end(), 0);
+    std::fill(m_allocated.begin(), m_allocated.end(), 0);
+    m_grid.Resize(m_capacity);
+
+    // Slot 0 on top. The stack never outgrows capacity, so this doesn't
+    // reallocate.
+    m_free.resize(m_capacity);
+    for (int i = 0; i < m_capacity; ++i) {
+        m_free[i] = m_capacity - 1 - i;
+    }
+}
+
+int FruitPool::Acquire() {
+    if (m_free.empty()) return -1;
+
+    int index = m_free.back();
+    m_free.pop_back();
+    m_allocated[index >> 6] |= uint64_t(1) << (index & 63);
+    m_count = std::max(m_count, index + 1);
+    return index;
+}
+
+void FruitPool::Release(int index) {
+    SetActive(index, false);
+    m_allocated[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    m_grid.Remove(index);
+    m_free.push_back(index);   // Never past capacity, so never reallocates
+}
+
+// Fruits per parallel chunk; a multiple of 64 so no two chunks share a
+// word of the active mask
+static const int UPDATE_GRAIN = 16384;
+static const int SPAWN_GRAIN  = 4096;
+
+void FruitPool::Update(float deltaTime, float speedMultiplier, JobSystem* jobs) {
+    const float step = speedMultiplier * deltaTime;
+    const int padded = (m_count + FRUIT_LANES - 1) / FRUIT_LANES * FRUIT_LANES;
+
+    if (!jobs) {
+        UpdateRange(step, 0, padded);
+        return;
+    }
+    auto body = [this, step](int begin, int end) { UpdateRange(step, begin, end); };
+    jobs->ParallelFor(padded, UPDATE_GRAIN, body);
+}
+
+void FruitPool::UpdateRange(float step, int begin, int end) {
+    uint8_t* mask = reinterpret_cast<uint8_t*>(m_active.data());
+
+#if defined(__AVX2__)
+    const __m256  vStep    = _mm256_set1_ps(step);
+    const __m256  vFloor   = _mm256_set1_ps(FLOOR_HEIGHT);
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    for (int i = begin; i < end; i += 8) {
+        unsigned bits = mask[i >> 3];
+        if (!bits) continue;
+
+        __m256i lanes  = _mm256_and_si256(_mm256_set1_epi32(bits), laneBits);
+        __m256  active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes, laneBits));
+
+        __m256 y     = _mm256_loadu_ps(&m_y[i]);
+        __m256 speed = _mm256_loadu_ps(&m_speed[i]);
+        _mm256_storeu_ps(&m_prevY[i], y);
+        y = _mm256_blendv_ps(y, _mm256_sub_ps(y, _mm256_mul_ps(speed, vStep)), active);
+        _mm256_storeu_ps(&m_y[i], y);
+
+        __m256 alive = _mm256_and_ps(active, _mm256_cmp_ps(y, vFloor, _CMP_NLT_UQ));
+        mask[i >> 3] = static_cast<uint8_t>(_mm256_movemask_ps(alive));
+    }
+#elif defined(__SSE2__)
+    const __m128  vStep    = _mm_set1_ps(step);
+    const __m128  vFloor   = _mm_set1_ps(FLOOR_HEIGHT);
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+
+    for (int i = begin; i < end; i += 4) {
+        int shift = i & 7;
+        unsigned bits = (mask[i >> 3] >> shift) & 0xFu;
+        if (!bits) continue;
+
+        __m128i lanes  = _mm_and_si128(_mm_set1_epi32(bits), laneBits);
+        __m128  active = _mm_castsi128_ps(_mm_cmpeq_epi32(lanes, laneBits));
+
+        __m128 y     = _mm_loadu_ps(&m_y[i]);
+        __m128 speed = _mm_loadu_ps(&m_speed[i]);
+        _mm_storeu_ps(&m_prevY[i], y);
+        __m128 moved = _mm_sub_ps(y, _mm_mul_ps(speed, vStep));
+        y = _mm_or_ps(_mm_and_ps(active, moved), _mm_andnot_ps(active, y));
+        _mm_storeu_ps(&m_y[i], y);
+
+        __m128 alive = _mm_and_ps(active, _mm_cmpnlt_ps(y, vFloor));
+        unsigned keep = static_cast<unsigned>(_mm_movemask_ps(alive));
+        mask[i >> 3] = static_cast<uint8_t>((mask[i >> 3] & ~(0xFu << shift)) | (keep << shift));
+    }
+#else
+    for (int i = begin; i < end; ++i) {
+        if (!IsActive(i)) continue;
+
+        m_prevY[i] = m_y[i];
+        m_y[i] -= m_speed[i] * step;
+
+        if (m_y[i] < FLOOR_HEIGHT) {
+            SetActive(i, false);
+        }
+    }
+#endif
+}
+
+void FruitPool::Cull(const Frustum& frustum, float alpha) {
+    const uint8_t* mask = reinterpret_cast<const uint8_t*>(m_active.data());
+    const int padded = (m_count + FRUIT_LANES - 1) / FRUIT_LANES * FRUIT_LANES;
+    int active = 0;
+    m_visible.clear();
+
+#if defined(__AVX2__)
+    __m256 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT];
+    __m256 planeZ[Frustum::PLANE_COUNT], planeD[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        planeX[p] = _mm256_set1_ps(frustum.Plane(p).nx);
+        planeY[p] = _mm256_set1_ps(frustum.Plane(p).ny);
+        planeZ[p] = _mm256_set1_ps(frustum.Plane(p).nz);
+        planeD[p] = _mm256_set1_ps(frustum.Plane(p).d);
+    }
+    const __m256 vAlpha = _mm256_set1_ps(alpha);
+    const __m256 zero   = _mm256_setzero_ps();
+
+    for (int i = 0; i < padded; i += 8) {
+        unsigned bits = mask[i >> 3];
+        if (!bits) continue;
+        active += __builtin_popcount(bits);
+
+        __m256 x     = _mm256_loadu_ps(&m_x[i]);
+        __m256 prevY = _mm256_loadu_ps(&m_prevY[i]);
+        __m256 y     = _mm256_add_ps(prevY, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_y[i]), prevY), vAlpha));
+        __m256 z     = _mm256_loadu_ps(&m_z[i]);
+        __m256 size  = _mm256_loadu_ps(&m_size[i]);
+
+        // Inside unless some plane has the whole sphere behind it
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeD[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, size), zero, _CMP_GE_OQ));
+        }
+
+        unsigned visible = bits & static_cast<unsigned>(_mm256_movemask_ps(inside));
+        while (visible) {
+            m_visible.push_back(i + __builtin_ctz(visible));
+            visible &= visible - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT];
+    __m128 planeZ[Frustum::PLANE_COUNT], planeD[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        planeX[p] = _mm_set1_ps(frustum.Plane(p).nx);
+        planeY[p] = _mm_set1_ps(frustum.Plane(p).ny);
+        planeZ[p] = _mm_set1_ps(frustum.Plane(p).nz);
+        planeD[p] = _mm_set1_ps(frustum.Plane(p).d);
+    }
+    const __m128 vAlpha = _mm_set1_ps(alpha);
+    const __m128 zero   = _mm_setzero_ps();
+
+    for (int i = 0; i < padded; i += 4) {
+        unsigned bits = (mask[i >> 3] >> (i & 7)) & 0xFu;
+        if (!bits) continue;
+        active += __builtin_popcount(bits);
+
+        __m128 x     = _mm_loadu_ps(&m_x[i]);
+        __m128 prevY = _mm_loadu_ps(&m_prevY[i]);
+        __m128 y     = _mm_add_ps(prevY, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_y[i]), prevY), vAlpha));
+        __m128 z     = _mm_loadu_ps(&m_z[i]);
+        __m128 size  = _mm_loadu_ps(&m_size[i]);
+
+        // Inside unless some plane has the whole sphere behind it
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeD[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, size), zero));
+        }
+
+        unsigned visible = bits & static_cast<unsigned>(_mm_movemask_ps(inside));
+        while (visible) {
+            m_visible.push_back(i + __builtin_ctz(visible));
+            visible &= visible - 1;
+        }
+    }
+#else
+    for (int i = 0; i < padded; ++i) {
+        if (!IsActive(i)) continue;
+        ++active;
+
+        float y = m_prevY[i] + (m_y[i] - m_prevY[i]) * alpha;
+        if (frustum.TestSphere(m_x[i], y, m_z[i], m_size[i])) {
+            m_visible.push_back(i);
+        }
+    }
+#endif
+
+    m_culled = active - static_cast<int>(m_visible.size());
+}
+
+void FruitPool::ReleaseLanded() {
+    // Allocated but no longer active: landed since the last call. Scan the
+    // mask a word at a time, highest slot first, so the lowest freed slot
+    // ends up on top of the free list.
+    for (int word = (m_count + 63) / 64 - 1; word >= 0; --word) {
+        uint64_t landed = m_allocated[word] & ~m_active[word];
+        while (landed) {
+            int bit = 63 - __builtin_clzll(landed);
+            Release(word * 64 + bit);
+            landed &= ~(uint64_t(1) << bit);
+        }
+    }
+}
+
+int FruitPool::Refill(int target, float height, float gameTime, Random& random, JobSystem* jobs) {
+    ReleaseLanded();
+
+    int count = std::min(target, m_capacity) - LiveCount();
+    if (count <= 0) return 0;
+
+    m_spawnIndices.clear();
+    for (int k = 0; k < count; ++k) {
+        m_spawnIndices.push_back(Acquire());
+    }
+    Spawn(m_spawnIndices.data(), count, gameTime, random, jobs);
+    for (int index : m_spawnIndices) {
+        m_y[index] = height;
+        m_prevY[index] = height;
+    }
+    return count;
+}
+
+void FruitPool::Spawn(const int* indices, int count, float gameTime, Random& random, JobSystem* jobs) {
+    // Four draws per fruit, generated in one batch: x, z, speed and the
+    // rainbow color pick. The stream is sequential; turning draws into
+    // fruits is not, so that part can be split.
+    m_draws.resize(count * 4);
+    random.Fill(m_draws.data(), count * 4);
+    const uint32_t* drawX     = m_draws.data();
+    const uint32_t* drawZ     = drawX + count;
+    const uint32_t* drawSpeed = drawZ + count;
+    const uint32_t* drawColor = drawSpeed + count;
+
+    // Integer x in [-halfWidth, halfWidth), z in [-halfDepth, halfDepth),
+    // speed in [5.0, 8.0) in 0.1 steps
+    const uint32_t width = 2 * m_spawnHalfWidth;
+    const uint32_t depth = 2 * m_spawnHalfDepth;
+    auto body = [&](int begin, int end) {
+        for (int k = begin; k < end; ++k) {
+            const int index = indices[k];
+            m_x[index] = static_cast<float>(static_cast<int>(Random::Below(drawX[k], width)) - m_spawnHalfWidth);
+            m_z[index] = static_cast<float>(static_cast<int>(Random::Below(drawZ[k], depth)) - m_spawnHalfDepth);
+            m_speed[index] = 5.0f + static_cast<float>(Random::Below(drawSpeed[k], 30)) / 10.0f;
+            SetAttributes(index, gameTime, drawColor[k]);
+        }
+    };
+    if (jobs) jobs->ParallelFor(count, SPAWN_GRAIN, body);
+    else body(0, count);
+
+    // Grid links and mask words are shared between fruits
+    for (int k = 0; k < count; ++k) {
+        const int index = indices[k];
+        m_grid.Move(index, m_x[index], m_z[index]);
+        SetActive(index, true);
+    }
+}
+
+void FruitPool::SetAttributes(int index, float gameTime, uint32_t colorDraw) {
+    if (m_type == FruitType::BLACK) {
+        // Set black fruit attributes
+        m_color[index] = Vector3(0.0f, 0.0f, 0.0f); // Black
+        m_size[index] = 0.5f; // Black fruit size
+        m_points[index] = -1; // Assuming black fruit deducts points
+        m_isRainbow[index] = false;
+    }
+    else { // FruitType::MAIN
+        // Determine main fruit type based on game time
+        if (gameTime <= 60.0f) {
+            // First 60 seconds: Red fruit
+            m_color[index] = Vector3(1.0f, 0.0f, 0.0f); // Red
+            m_size[index] = 0.5f; // Appropriate size
+            m_points[index] = 1;
+            m_isRainbow[index] = false;
+        }
+        else if (gameTime <= 100.0f) {
+            // 60-100 seconds: Yellow fruit
+            m_color[index] = Vector3(1.0f, 1.0f, 0.0f); // Yellow
+            m_size[index] = 0.7f; // Appropriate size
+            m_points[index] = 2;
+            m_isRainbow[index] = false;
+        }
+        else if (gameTime <= 120.0f) {
+            // 100-120 seconds: Rainbow fruit
+            // Randomly choose one of four colors
+            static const Vector3 RAINBOW_START[4] = {
+                Vector3(1.0f, 0.0f, 0.0f),   // Red
+                Vector3(0.0f, 1.0f, 0.0f),   // Green
+                Vector3(0.0f, 0.0f, 1.0f),   // Blue
+                Vector3(1.0f, 0.0f, 1.0f)    // Purple
+            };
+            m_color[index] = RAINBOW_START[Random::Below(colorDraw, 4)];
+            m_size[index] = 1.0f; // Appropriate size
+            m_points[index] = 10;
+            m_isRainbow[index] = true; // Enable rainbow effect
+        }
+    }
+}
+
+void FruitPool::SaveState(std::vector<uint8_t>& out) const {
+    StateWriter writer(out);
+    writer.Write(static_cast<int32_t>(m_capacity));
+    writer.Write(static_cast<int32_t>(m_count));
+    writer.Write(static_cast<int32_t>(m_spawnHalfWidth));
+    writer.Write(static_cast<int32_t>(m_spawnHalfDepth));
+    writer.WriteArray(m_x);
+    writer.WriteArray(m_y);
+    writer.WriteArray(m_prevY);
+    writer.WriteArray(m_z);
+    writer.WriteArray(m_speed);
+    writer.WriteArray(m_size);
+    writer.WriteArray(m_active);
+    writer.WriteArray(m_allocated);
+    writer.WriteArray(m_free);
+    writer.WriteArray(m_color);
+    writer.WriteArray(m_points);
+    writer.WriteArray(m_isRainbow);
+}
+
+bool FruitPool::LoadState(StateReader& in) {
+    int32_t capacity = 0, count = 0, halfWidth = 0, halfDepth = 0;
+    in.Read(capacity);
+    in.Read(count);
+    in.Read(halfWidth);
+    in.Read(halfDepth);
+    if (!in.Ok() || capacity < 0 || count < 0 || count > capacity || halfWidth <= 0 || halfDepth <= 0) {
+        return false;
+    }
+
+    SetSpawnArea(halfWidth, halfDepth);
+    if (capacity != m_capacity) Reserve(capacity);
+    else Clear();
+    const size_t padded = m_x.size();
+    const size_t words  = m_active.size();
+
+    in.ReadArray(m_x);
+    in.ReadArray(m_y);
+    in.ReadArray(m_prevY);
+    in.ReadArray(m_z);
+    in.ReadArray(m_speed);
+    in.ReadArray(m_size);
+    in.ReadArray(m_active);
+    in.ReadArray(m_allocated);
+    in.ReadArray(m_free);
+    in.ReadArray(m_color);
+    in.ReadArray(m_points);
+    in.ReadArray(m_isRainbow);
+
+    bool sized = m_x.size() == padded && m_y.size() == padded && m_prevY.size() == padded &&
+                 m_z.size() == padded && m_speed.size() == padded && m_size.size() == padded &&
+                 m_active.size() == words && m_allocated.size() == words &&
+                 m_free.size() <= size_t(capacity) && m_color.size() == size_t(capacity) &&
+                 m_points.size() == size_t(capacity) && m_isRainbow.size() == size_t(capacity);
+
+    // Every slot is either allocated or on the free list, never both
+    int allocated = 0;
+    for (size_t word = 0; sized && word < words; ++word) {
+        allocated += __builtin_popcountll(m_allocated[word]);
+    }
+    bool consistent = sized && allocated + m_free.size() == size_t(capacity);
+    for (size_t i = 0; consistent && i < m_free.size(); ++i) {
+        int index = m_free[i];
+        consistent = index >= 0 && index < capacity &&
+                     !((m_allocated[index >> 6] >> (index & 63)) & 1u);
+    }
+    if (!in.Ok() || !consistent) {
+        Reserve(0);
+        return false;
+    }
+
+    m_count = count;
+    for (int i = 0; i < m_count; ++i) {
+        if ((m_allocated[i >> 6] >> (i & 63)) & 1u) {
+            m_grid.Move(i, m_x[i], m_z[i]);
+        }
+    }
+    return true;
+}
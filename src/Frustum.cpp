@@ -0,0 +1,62 @@
+#include "../include/Frustum.h"
+#include <cmath>
+
+Frustum::Frustum() {
+    // Accepts everything until the first Extract()
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        m_planes[i] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    }
+}
+
+void Frustum::Extract(const float projection[16], const float modelview[16]) {
+    // clip = projection * modelview, column-major: clip[col * 4 + row]
+    float clip[16];
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) {
+                sum += projection[k * 4 + row] * modelview[col * 4 + k];
+            }
+            clip[col * 4 + row] = sum;
+        }
+    }
+
+    // A point is inside when -w <= x, y, z <= w in clip space, so each
+    // plane is the w row plus or minus the x, y or z row
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        int axis = i / 2;
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        float a = clip[0 * 4 + 3] + sign * clip[0 * 4 + axis];
+        float b = clip[1 * 4 + 3] + sign * clip[1 * 4 + axis];
+        float c = clip[2 * 4 + 3] + sign * clip[2 * 4 + axis];
+        float d = clip[3 * 4 + 3] + sign * clip[3 * 4 + axis];
+
+        float length = std::sqrt(a * a + b * b + c * c);
+        if (length > 0.0f) {
+            a /= length; b /= length; c /= length; d /= length;
+        }
+        m_planes[i] = { a, b, c, d };
+    }
+}
+
+bool Frustum::TestSphere(float x, float y, float z, float radius) const {
+    for (const FrustumPlane& plane : m_planes) {
+        if (plane.nx * x + plane.ny * y + plane.nz * z + plane.d < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::TestBox(const float minCorner[3], const float maxCorner[3]) const {
+    // Outside only if the corner furthest along a plane's normal is behind it
+    for (const FrustumPlane& plane : m_planes) {
+        float x = plane.nx >= 0.0f ? maxCorner[0] : minCorner[0];
+        float y = plane.ny >= 0.0f ? maxCorner[1] : minCorner[1];
+        float z = plane.nz >= 0.0f ? maxCorner[2] : minCorner[2];
+        if (plane.nx * x + plane.ny * y + plane.nz * z + plane.d < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,339 @@
+#include "../include/GameWorld.h"
+#include "../include/Collision.h"
+#include "../include/Profiler.h"
+#include "../include/Serialize.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+GameWorld::GameWorld()
+    : m_playing(false), m_over(false), m_difficulty(MEDIUM), m_seed(1),
+      m_score(0), m_life(20), m_gameTime(0.0f),
+      m_cameraSpeed(0.1f), m_fruitSpeedMultiplier(1.0f),
+      m_isExploding(false), m_explosionTime(0.0f),
+      m_position(0.0f, 2.0f, 6.0f), m_view(0.0f, 0.0f, 0.0f), m_upVector(0.0f, 1.0f, 0.0f),
+      m_yaw(-90.0f), m_pitch(0.0f),
+      m_mainFruits(FruitType::MAIN), m_blackFruits(FruitType::BLACK), m_jobs(nullptr) {
+    m_schedule = DefaultSpawnSchedule(m_difficulty);
+}
+
+SpawnSchedule DefaultSpawnSchedule(Difficulty diff) {
+    // Main balls double over the round, black balls grow by half
+    switch (diff) {
+        case EASY:
+            return { 5, 10, 3, 4 };
+        case HARD:
+            return { 10, 20, 7, 10 };
+        case MEDIUM:
+        default:
+            return { 7, 14, 5, 7 };
+    }
+}
+
+void GameWorld::ReserveFruits(int mainCapacity, int blackCapacity) {
+    m_mainFruits.Reserve(mainCapacity);
+    m_blackFruits.Reserve(blackCapacity);
+
+    // A step never finds more candidates or hits than one pool has slots
+    int largest = std::max(mainCapacity, blackCapacity);
+    m_candidates.reserve(largest);
+    m_hits.reserve(largest);
+}
+
+void GameWorld::Start(Difficulty diff) {
+    Start(diff, DefaultSpawnSchedule(diff));
+}
+
+void GameWorld::Start(Difficulty diff, int mainCount, int blackCount) {
+    SpawnSchedule schedule = { mainCount, mainCount, blackCount, blackCount };
+    Start(diff, schedule);
+}
+
+void GameWorld::Start(Difficulty diff, const SpawnSchedule& schedule) {
+    m_playing    = true;
+    m_over       = false;
+    m_difficulty = diff;
+    m_schedule   = schedule;
+    m_score      = 0;
+    m_gameTime   = 0.0f;
+
+    switch (diff) {
+        case EASY:
+            m_life = 5;
+            m_fruitSpeedMultiplier = 1.0f;
+            break;
+        case MEDIUM:
+            m_life = 3;
+            m_fruitSpeedMultiplier = 1.5f;
+            break;
+        case HARD:
+            m_life = 1;
+            m_fruitSpeedMultiplier = 2.0f;
+            break;
+    }
+
+    m_isExploding   = false;
+    m_explosionTime = 0.0f;
+
+    // Only grows when the pools weren't reserved for this schedule
+    if (m_mainFruits.Capacity() < schedule.mainPeak) m_mainFruits.Reserve(schedule.mainPeak);
+    if (m_blackFruits.Capacity() < schedule.blackPeak) m_blackFruits.Reserve(schedule.blackPeak);
+
+    m_random.Seed(m_seed);
+    m_mainFruits.Reset(schedule.mainStart, BallHeight, 5.0f, m_random, m_jobs);
+    m_blackFruits.Reset(schedule.blackStart, BallHeight, 5.0f, m_random, m_jobs);
+
+    m_position = Vector3(0.0f, 2.0f, 6.0f);
+    m_view     = Vector3(0.0f, 0.0f, 0.0f);
+    m_upVector = Vector3(0.0f, 1.0f, 0.0f);
+    m_yaw      = -90.0f;
+    m_pitch    = 0.0f;
+}
+
+void GameWorld::EndGame() {
+    m_playing = false;
+    m_over    = true;
+}
+
+void GameWorld::AdjustSpeed(float delta) {
+    m_cameraSpeed          = std::max(0.1f, m_cameraSpeed + delta);
+    m_fruitSpeedMultiplier = std::max(0.1f, m_fruitSpeedMultiplier + delta);
+}
+
+int GameWorld::TargetCount(int start, int peak) const {
+    float progress = std::min(m_gameTime / GAME_DURATION, 1.0f);
+    return start + static_cast<int>((peak - start) * progress);
+}
+
+float GameWorld::GetRemainingTime() const {
+    float remaining = GAME_DURATION - m_gameTime;
+    return remaining < 0.0f ? 0.0f : remaining;
+}
+
+void GameWorld::Step(float deltaTime, const GameInput& input) {
+    if (!m_playing) return;
+
+    if (input.endGame) {
+        EndGame();
+        return;
+    }
+    if (input.speedDelta != 0.0f) {
+        AdjustSpeed(input.speedDelta);
+    }
+
+    if (m_isExploding) {
+        m_explosionTime += deltaTime;
+        if (m_explosionTime >= EXPLOSION_DURATION) {
+            m_isExploding = false;
+            m_explosionTime = 0.0f;
+        }
+    }
+
+    m_gameTime += deltaTime;
+    if (m_gameTime >= GAME_DURATION) {
+        EndGame();
+        return;
+    }
+
+    ApplyLook(input);
+    ApplyMovement(input);
+
+    {
+        ProfileScope scope(PHASE_UPDATE);
+        m_mainFruits.Update(deltaTime * m_fruitSpeedMultiplier, m_fruitSpeedMultiplier, m_jobs);
+        m_blackFruits.Update(deltaTime * m_fruitSpeedMultiplier, m_fruitSpeedMultiplier, m_jobs);
+    }
+
+    {
+        ProfileScope scope(PHASE_COLLISION);
+        CheckCollisions();
+    }
+
+    {
+        ProfileScope scope(PHASE_RESET);
+        m_mainFruits.Refill(TargetCount(m_schedule.mainStart, m_schedule.mainPeak),
+                            BallHeight, m_gameTime, m_random, m_jobs);
+        m_blackFruits.Refill(TargetCount(m_schedule.blackStart, m_schedule.blackPeak),
+                             BallHeight, m_gameTime, m_random, m_jobs);
+    }
+}
+
+void GameWorld::ApplyLook(const GameInput& input) {
+    if (input.yawDelta == 0.0f && input.pitchDelta == 0.0f) return;
+
+    m_yaw   += input.yawDelta;
+    m_pitch += input.pitchDelta;
+
+    if (m_pitch > 89.0f)  m_pitch = 89.0f;
+    if (m_pitch < -89.0f) m_pitch = -89.0f;
+
+    Vector3 direction;
+    direction.x = cos(m_yaw * 0.0174532925f) * cos(m_pitch * 0.0174532925f);
+    direction.y = sin(m_pitch * 0.0174532925f);
+    direction.z = sin(m_yaw * 0.0174532925f) * cos(m_pitch * 0.0174532925f);
+    direction.Normalize();
+
+    m_view = m_position + direction;
+}
+
+void GameWorld::ApplyMovement(const GameInput& input) {
+    float speed = m_cameraSpeed;
+    if (input.sprint) {
+        speed *= 2.0f;
+    }
+
+    Vector3 forward = m_view - m_position;
+    forward.y = 0;
+    forward.Normalize();
+
+    Vector3 right = forward.Cross(m_upVector);
+    right.Normalize();
+
+    Vector3 movement(0, 0, 0);
+    if (input.forward) {
+        movement = movement + (forward * speed);
+    }
+    if (input.backward) {
+        movement = movement - (forward * speed);
+    }
+    if (input.left) {
+        movement = movement - (right * speed);
+    }
+    if (input.right) {
+        movement = movement + (right * speed);
+    }
+
+    Vector3 newPosition = m_position + movement;
+
+    bool collision = false;
+
+    if (newPosition.x >= WALL_DISTANCE - WALL_BUFFER || newPosition.x <= -WALL_DISTANCE + WALL_BUFFER) {
+        collision = true;
+    }
+    if (newPosition.z >= WALL_DISTANCE - WALL_BUFFER || newPosition.z <= -WALL_DISTANCE + WALL_BUFFER) {
+        collision = true;
+    }
+
+    if (!collision) {
+        m_position = newPosition;
+        m_view     = m_view + movement;
+    }
+}
+
+void GameWorld::CheckCollisions() {
+    CheckFruits(m_mainFruits, false);
+    CheckFruits(m_blackFruits, true);
+}
+
+void GameWorld::CheckFruits(FruitPool& fruits, bool explodes) {
+    CatchVolume volume = MakeCatchVolume(m_position, m_view);
+
+    m_hits.clear();
+    QueryCatches(fruits, volume, m_candidates, m_hits, m_jobs);
+
+    // Score and life change in index order, whoever found the hits
+    for (int index : m_hits) {
+        ScoreFruit(fruits, index, explodes);
+    }
+}
+
+void GameWorld::ScoreFruit(FruitPool& fruits, int index, bool explodes) {
+    if (explodes) {
+        m_isExploding = true;
+        m_explosionTime = 0.0f;
+    }
+
+    int points = fruits.GetPoints(index);
+    m_score += points;
+    if (points < 0) {
+        m_life--;
+        if (m_life <= 0) {
+            EndGame();
+        }
+    }
+    fruits.Release(index);
+}
+
+void GameWorld::SaveState(std::vector<uint8_t>& out) const {
+    StateWriter writer(out);
+    writer.Write(static_cast<uint8_t>(m_playing));
+    writer.Write(static_cast<uint8_t>(m_over));
+    writer.Write(static_cast<int32_t>(m_difficulty));
+    writer.Write(m_seed);
+    writer.Write(m_schedule);
+    writer.Write(m_random.GetState());
+    writer.Write(static_cast<int32_t>(m_score));
+    writer.Write(static_cast<int32_t>(m_life));
+    writer.Write(m_gameTime);
+    writer.Write(m_cameraSpeed);
+    writer.Write(m_fruitSpeedMultiplier);
+    writer.Write(static_cast<uint8_t>(m_isExploding));
+    writer.Write(m_explosionTime);
+    writer.Write(m_position);
+    writer.Write(m_view);
+    writer.Write(m_upVector);
+    writer.Write(m_yaw);
+    writer.Write(m_pitch);
+    m_mainFruits.SaveState(out);
+    m_blackFruits.SaveState(out);
+}
+
+bool GameWorld::LoadState(const uint8_t* data, size_t size) {
+    // Everything goes into locals first, so a truncated or corrupt
+    // snapshot leaves the world as it was
+    StateReader reader(data, size);
+    uint8_t playing = 0, over = 0, exploding = 0;
+    int32_t difficulty = 0, score = 0, life = 0;
+    uint32_t seed = 0;
+    Random::State random;
+    SpawnSchedule schedule = {};
+    float gameTime = 0.0f, cameraSpeed = 0.0f, speedMultiplier = 0.0f, explosionTime = 0.0f;
+    Vector3 position, view, upVector;
+    float yaw = 0.0f, pitch = 0.0f;
+
+    reader.Read(playing);
+    reader.Read(over);
+    reader.Read(difficulty);
+    reader.Read(seed);
+    reader.Read(schedule);
+    reader.Read(random);
+    reader.Read(score);
+    reader.Read(life);
+    reader.Read(gameTime);
+    reader.Read(cameraSpeed);
+    reader.Read(speedMultiplier);
+    reader.Read(exploding);
+    reader.Read(explosionTime);
+    reader.Read(position);
+    reader.Read(view);
+    reader.Read(upVector);
+    reader.Read(yaw);
+    reader.Read(pitch);
+    if (!reader.Ok() || difficulty < EASY || difficulty > HARD) return false;
+
+    FruitPool mainFruits(FruitType::MAIN);
+    FruitPool blackFruits(FruitType::BLACK);
+    if (!mainFruits.LoadState(reader) || !blackFruits.LoadState(reader)) return false;
+
+    m_playing              = playing != 0;
+    m_over                 = over != 0;
+    m_difficulty           = static_cast<Difficulty>(difficulty);
+    m_seed                 = seed;
+    m_schedule             = schedule;
+    m_score                = score;
+    m_life                 = life;
+    m_gameTime             = gameTime;
+    m_cameraSpeed          = cameraSpeed;
+    m_fruitSpeedMultiplier = speedMultiplier;
+    m_isExploding          = exploding != 0;
+    m_explosionTime        = explosionTime;
+    m_position             = position;
+    m_view                 = view;
+    m_upVector             = upVector;
+    m_yaw                  = yaw;
+    m_pitch                = pitch;
+    m_mainFruits           = std::move(mainFruits);
+    m_blackFruits          = std::move(blackFruits);
+    m_random.SetState(random);
+    return true;
+}
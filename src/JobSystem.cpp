@@ -0,0 +1,121 @@
+#include "../include/JobSystem.h"
+#include <algorithm>
+
+// Chunks per thread; a few more than one so threads that finish early
+// have something to steal
+static const int CHUNKS_PER_THREAD = 4;
+
+JobSystem::JobSystem(int threadCount)
+    : m_threadCount(threadCount), m_queued(0), m_stop(false) {
+    if (m_threadCount <= 0) {
+        m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::Start() {
+    for (int i = 0; i < m_threadCount; ++i) {
+        m_queues.emplace_back(new Queue());
+    }
+    for (int i = 1; i < m_threadCount; ++i) {
+        m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+    }
+}
+
+void JobSystem::ParallelFor(int count, int grain, RangeFunc func, void* context) {
+    if (count <= 0) return;
+    grain = std::max(grain, 1);
+    if (m_threadCount == 1 || count <= grain) {
+        func(context, 0, count);
+        return;
+    }
+    if (m_queues.empty()) {
+        Start();
+    }
+
+    // Whole grains per chunk, about CHUNKS_PER_THREAD chunks per thread
+    int grains = (count + grain - 1) / grain;
+    int chunks = std::min(grains, m_threadCount * CHUNKS_PER_THREAD);
+    int chunkSize = (grains + chunks - 1) / chunks * grain;
+    chunks = (count + chunkSize - 1) / chunkSize;
+
+    Batch batch;
+    batch.remaining.store(chunks, std::memory_order_relaxed);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        Task task = { func, context, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize), &batch };
+        Queue& queue = *m_queues[chunk % m_threadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued.fetch_add(chunks, std::memory_order_release);
+    }
+    m_wake.notify_all();
+
+    // Help until our chunks are done; tasks left over are being run by
+    // workers that already took them
+    Task task;
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if (TakeTask(0, task)) {
+            RunTask(task);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::TakeTask(int index, Task& task) {
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    for (int i = 1; i < m_threadCount; ++i) {
+        Queue& victim = *m_queues[(index + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::RunTask(const Task& task) {
+    task.func(task.context, task.begin, task.end);
+    task.batch->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::WorkerMain(int index) {
+    Task task;
+    for (;;) {
+        if (TakeTask(index, task)) {
+            RunTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+        if (m_stop) return;
+    }
+}
@@ -0,0 +1,235 @@
+#include "../include/NetProtocol.h"
+#include "../include/Serialize.h"
+#include <algorithm>
+#include <cmath>
+
+static int16_t Quantize(float value, float scale) {
+    float q = std::round(value * scale);
+    if (q > 32767.0f)  q = 32767.0f;
+    if (q < -32768.0f) q = -32768.0f;
+    return static_cast<int16_t>(q);
+}
+
+static void CaptureBalls(const FruitPool& fruits, bool black, std::vector<NetBall>& out) {
+    const float* x = fruits.X();
+    const float* y = fruits.Y();
+    const float* z = fruits.Z();
+    for (int i = 0; i < fruits.Size(); ++i) {
+        // Released slots keep their last position, so a ball landing only
+        // changes its flags
+        NetBall ball;
+        ball.x = Quantize(x[i], 16.0f);
+        ball.z = Quantize(z[i], 16.0f);
+        ball.y = Quantize(y[i], 32.0f);
+        ball.flags = 0;
+        if (fruits.IsActive(i)) {
+            ball.flags = NET_BALL_ACTIVE;
+            if (black)                   ball.flags |= NET_BALL_BLACK;
+            if (fruits.GetPoints(i) > 1) ball.flags |= NET_BALL_BONUS;
+        }
+        out.push_back(ball);
+    }
+}
+
+void CaptureSnapshot(const GameWorld& world, uint16_t round, NetSnapshot& out) {
+    const Vector3& position = world.GetPosition();
+    const Vector3& view = world.GetView();
+    float dx = view.x - position.x;
+    float dy = view.y - position.y;
+    float dz = view.z - position.z;
+    const float degrees = 57.2957795f;
+
+    NetPlayer& player = out.player;
+    player.x = Quantize(position.x, 64.0f);
+    player.y = Quantize(position.y, 64.0f);
+    player.z = Quantize(position.z, 64.0f);
+    player.yaw   = Quantize(std::atan2(dz, dx) * degrees, 100.0f);
+    player.pitch = Quantize(std::atan2(dy, std::sqrt(dx * dx + dz * dz)) * degrees, 100.0f);
+    player.score = Quantize(static_cast<float>(world.GetScore()), 1.0f);
+    player.life  = static_cast<int8_t>(std::max(-128, std::min(127, world.GetLife())));
+    player.flags = world.IsExploding() ? NET_PLAYER_EXPLODING : 0;
+    player.timeLeft = static_cast<uint16_t>(std::round(world.GetRemainingTime() * 10.0f));
+    player.round = round;
+
+    out.mainCount  = static_cast<uint16_t>(world.GetMainFruits().Size());
+    out.blackCount = static_cast<uint16_t>(world.GetBlackFruits().Size());
+    out.balls.clear();
+    CaptureBalls(world.GetMainFruits(), false, out.balls);
+    CaptureBalls(world.GetBlackFruits(), true, out.balls);
+}
+
+// Field bits of the per-record change masks
+enum PlayerField {
+    PLAYER_POSITION = 1 << 0,
+    PLAYER_VIEW     = 1 << 1,
+    PLAYER_SCORE    = 1 << 2,
+    PLAYER_LIFE     = 1 << 3,
+    PLAYER_FLAGS    = 1 << 4,
+    PLAYER_TIME     = 1 << 5,
+    PLAYER_ROUND    = 1 << 6
+};
+
+enum BallField {
+    BALL_X      = 1 << 0,
+    BALL_Z      = 1 << 1,
+    BALL_Y_STEP = 1 << 2,   // int8 change from the base height
+    BALL_Y      = 1 << 3,   // Full int16 height
+    BALL_FLAGS  = 1 << 4
+};
+
+static const NetBall ZERO_BALL = { 0, 0, 0, 0 };
+
+// Slot i of state compared against the same pool slot of base; slots the
+// base doesn't have compare against zero
+static const NetBall& BaseBall(const NetSnapshot* base, const NetSnapshot& state, size_t i) {
+    if (!base) return ZERO_BALL;
+    if (i < state.mainCount) {
+        return i < base->mainCount ? base->balls[i] : ZERO_BALL;
+    }
+    size_t black = i - state.mainCount;
+    return black < base->blackCount ? base->balls[base->mainCount + black] : ZERO_BALL;
+}
+
+void EncodeSnapshot(const NetSnapshot& state, const NetSnapshot* base, std::vector<uint8_t>& out) {
+    static const NetPlayer ZERO_PLAYER = {};
+    const NetPlayer& was = base ? base->player : ZERO_PLAYER;
+    const NetPlayer& now = state.player;
+
+    StateWriter writer(out);
+    writer.Write(state.mainCount);
+    writer.Write(state.blackCount);
+
+    uint8_t playerMask = 0;
+    if (now.x != was.x || now.y != was.y || now.z != was.z) playerMask |= PLAYER_POSITION;
+    if (now.yaw != was.yaw || now.pitch != was.pitch)       playerMask |= PLAYER_VIEW;
+    if (now.score != was.score)       playerMask |= PLAYER_SCORE;
+    if (now.life != was.life)         playerMask |= PLAYER_LIFE;
+    if (now.flags != was.flags)       playerMask |= PLAYER_FLAGS;
+    if (now.timeLeft != was.timeLeft) playerMask |= PLAYER_TIME;
+    if (now.round != was.round)       playerMask |= PLAYER_ROUND;
+    writer.Write(playerMask);
+    if (playerMask & PLAYER_POSITION) {
+        writer.Write(now.x);
+        writer.Write(now.y);
+        writer.Write(now.z);
+    }
+    if (playerMask & PLAYER_VIEW) {
+        writer.Write(now.yaw);
+        writer.Write(now.pitch);
+    }
+    if (playerMask & PLAYER_SCORE) writer.Write(now.score);
+    if (playerMask & PLAYER_LIFE)  writer.Write(now.life);
+    if (playerMask & PLAYER_FLAGS) writer.Write(now.flags);
+    if (playerMask & PLAYER_TIME)  writer.Write(now.timeLeft);
+    if (playerMask & PLAYER_ROUND) writer.Write(now.round);
+
+    // One bit per slot for "changed", then the changed slots' records
+    size_t count = state.balls.size();
+    size_t bitmap = out.size();
+    out.resize(bitmap + (count + 7) / 8, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const NetBall& ball = state.balls[i];
+        const NetBall& old = BaseBall(base, state, i);
+
+        uint8_t mask = 0;
+        if (ball.x != old.x) mask |= BALL_X;
+        if (ball.z != old.z) mask |= BALL_Z;
+        if (ball.y != old.y) {
+            int step = ball.y - old.y;
+            mask |= (step >= -128 && step <= 127) ? BALL_Y_STEP : BALL_Y;
+        }
+        if (ball.flags != old.flags) mask |= BALL_FLAGS;
+        if (mask == 0) continue;
+
+        out[bitmap + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        writer.Write(mask);
+        if (mask & BALL_X)      writer.Write(ball.x);
+        if (mask & BALL_Z)      writer.Write(ball.z);
+        if (mask & BALL_Y_STEP) writer.Write(static_cast<int8_t>(ball.y - old.y));
+        if (mask & BALL_Y)      writer.Write(ball.y);
+        if (mask & BALL_FLAGS)  writer.Write(ball.flags);
+    }
+}
+
+bool DecodeSnapshot(const uint8_t* data, size_t size, const NetSnapshot* base, NetSnapshot& out) {
+    static const NetPlayer ZERO_PLAYER = {};
+    StateReader reader(data, size);
+    reader.Read(out.mainCount);
+    reader.Read(out.blackCount);
+
+    uint8_t playerMask = 0;
+    reader.Read(playerMask);
+    NetPlayer& now = out.player;
+    now = base ? base->player : ZERO_PLAYER;
+    if (playerMask & PLAYER_POSITION) {
+        reader.Read(now.x);
+        reader.Read(now.y);
+        reader.Read(now.z);
+    }
+    if (playerMask & PLAYER_VIEW) {
+        reader.Read(now.yaw);
+        reader.Read(now.pitch);
+    }
+    if (playerMask & PLAYER_SCORE) reader.Read(now.score);
+    if (playerMask & PLAYER_LIFE)  reader.Read(now.life);
+    if (playerMask & PLAYER_FLAGS) reader.Read(now.flags);
+    if (playerMask & PLAYER_TIME)  reader.Read(now.timeLeft);
+    if (playerMask & PLAYER_ROUND) reader.Read(now.round);
+    if (!reader.Ok()) return false;
+
+    size_t count = size_t(out.mainCount) + out.blackCount;
+    std::vector<uint8_t> changed((count + 7) / 8);
+    for (uint8_t& bits : changed) {
+        reader.Read(bits);
+    }
+    out.balls.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        NetBall ball = BaseBall(base, out, i);
+        if (changed[i / 8] & (1u << (i % 8))) {
+            uint8_t mask = 0;
+            reader.Read(mask);
+            if (mask & BALL_X) reader.Read(ball.x);
+            if (mask & BALL_Z) reader.Read(ball.z);
+            if (mask & BALL_Y_STEP) {
+                int8_t step = 0;
+                reader.Read(step);
+                ball.y = static_cast<int16_t>(ball.y + step);
+            }
+            if (mask & BALL_Y)     reader.Read(ball.y);
+            if (mask & BALL_FLAGS) reader.Read(ball.flags);
+        }
+        out.balls[i] = ball;
+    }
+    return reader.Ok();
+}
+
+static uint32_t Mix(uint32_t hash, int value, int bytes) {
+    for (int b = 0; b < bytes; ++b) {
+        hash = (hash ^ static_cast<uint8_t>(value >> (8 * b))) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t HashSnapshot(const NetSnapshot& state) {
+    const NetPlayer& p = state.player;
+    uint32_t hash = 2166136261u;
+    hash = Mix(hash, p.x, 2);
+    hash = Mix(hash, p.y, 2);
+    hash = Mix(hash, p.z, 2);
+    hash = Mix(hash, p.yaw, 2);
+    hash = Mix(hash, p.pitch, 2);
+    hash = Mix(hash, p.score, 2);
+    hash = Mix(hash, p.life, 1);
+    hash = Mix(hash, p.flags, 1);
+    hash = Mix(hash, p.timeLeft, 2);
+    hash = Mix(hash, p.round, 2);
+    hash = Mix(hash, state.mainCount, 2);
+    hash = Mix(hash, state.blackCount, 2);
+    for (const NetBall& ball : state.balls) {
+        hash = Mix(hash, ball.x, 2);
+        hash = Mix(hash, ball.z, 2);
+        hash = Mix(hash, ball.y, 2);
+        hash = Mix(hash, ball.flags, 1);
+    }
+    return hash;
+}
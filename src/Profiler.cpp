@@ -0,0 +1,126 @@
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "input", "update", "collision", "reset", "arena", "ring", "balls", "hud", "capture"
+};
+
+static const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+    "draw_calls", "state_changes", "balls_drawn", "balls_culled"
+};
+
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+    : m_enabled(false), m_frameStart(std::chrono::steady_clock::now()), m_written(0) {
+    memset(&m_current, 0, sizeof(m_current));
+}
+
+const char* Profiler::PhaseName(ProfilePhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+const char* Profiler::CounterName(ProfileCounter counter) {
+    return COUNTER_NAMES[counter];
+}
+
+void Profiler::EndFrame() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (!m_enabled) {
+        m_frameStart = now;
+        return;
+    }
+
+    m_current.frameMs = std::chrono::duration<float, std::milli>(now - m_frameStart).count();
+    m_frameStart = now;
+
+    uint64_t written = m_written.load(std::memory_order_relaxed);
+    m_samples[written % CAPACITY] = m_current;
+    m_written.store(written + 1, std::memory_order_release);
+
+    memset(&m_current, 0, sizeof(m_current));
+}
+
+void Profiler::DiscardFrame() {
+    m_frameStart = std::chrono::steady_clock::now();
+    memset(&m_current, 0, sizeof(m_current));
+}
+
+int Profiler::Recent(FrameSample* out, int maxCount) const {
+    uint64_t written = m_written.load(std::memory_order_acquire);
+    int count = static_cast<int>(std::min<uint64_t>({ written, uint64_t(CAPACITY), uint64_t(maxCount) }));
+    for (int i = 0; i < count; ++i) {
+        out[i] = m_samples[(written - count + i) % CAPACITY];
+    }
+    return count;
+}
+
+float Percentile(const std::vector<float>& sorted, float fraction) {
+    size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+int Profiler::ComputeStats(int window, PhaseStats out[PHASE_COUNT + 1]) const {
+    std::vector<FrameSample>& frames = m_statFrames;
+    std::vector<float>& values = m_statValues;
+    frames.resize(std::min(window, int(CAPACITY)));
+    int count = Recent(frames.data(), static_cast<int>(frames.size()));
+
+    for (int phase = 0; phase <= PHASE_COUNT; ++phase) {
+        out[phase].averageMs = 0.0f;
+        out[phase].p99Ms     = 0.0f;
+        if (count == 0) continue;
+
+        values.clear();
+        float sum = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            float ms = phase < PHASE_COUNT ? frames[i].phaseMs[phase] : frames[i].frameMs;
+            values.push_back(ms);
+            sum += ms;
+        }
+        out[phase].averageMs = sum / count;
+        // Same rank as the tools and --render-bench report
+        std::sort(values.begin(), values.end());
+        out[phase].p99Ms     = Percentile(values, 0.99f);
+    }
+    return count;
+}
+
+bool Profiler::ExportCsv(const char* path) const {
+    std::vector<FrameSample> frames(CAPACITY);
+    int count = Recent(frames.data(), CAPACITY);
+
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame");
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        fprintf(file, ",%s_ms", PHASE_NAMES[phase]);
+    }
+    fprintf(file, ",frame_ms");
+    for (int counter = 0; counter < COUNTER_COUNT; ++counter) {
+        fprintf(file, ",%s", COUNTER_NAMES[counter]);
+    }
+    fprintf(file, "\n");
+
+    uint64_t first = m_written.load(std::memory_order_acquire) - count;
+    for (int i = 0; i < count; ++i) {
+        fprintf(file, "%llu", static_cast<unsigned long long>(first + i));
+        for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+            fprintf(file, ",%.4f", frames[i].phaseMs[phase]);
+        }
+        fprintf(file, ",%.4f", frames[i].frameMs);
+        for (int counter = 0; counter < COUNTER_COUNT; ++counter) {
+            fprintf(file, ",%u", frames[i].counters[counter]);
+        }
+        fprintf(file, "\n");
+    }
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,23 @@
+#include "../include/Random.h"
+
+void Random::Seed(uint64_t seed) {
+    // splitmix64 spreads any seed, including 0, over a non-zero state
+    for (int i = 0; i < 2; ++i) {
+        seed += 0x9E3779B97F4A7C15ull;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        m_state.s[i * 2]     = static_cast<uint32_t>(z);
+        m_state.s[i * 2 + 1] = static_cast<uint32_t>(z >> 32);
+    }
+}
+
+void Random::Fill(uint32_t* out, int count) {
+    // Work on a local copy so the state stays in registers
+    Random local = *this;
+    for (int i = 0; i < count; ++i) {
+        out[i] = local.Next();
+    }
+    m_state = local.m_state;
+}
@@ -0,0 +1,132 @@
+#include "../include/RenderQueue.h"
+#include <algorithm>
+
+// Sort key, high bits first:
+//   pass (2) | opaque:  program (16) texture (16) blend lighting depth (3) sequence (27)
+//            | ordered: sequence (27) program (16) texture (16) blend lighting depth (3)
+// The sequence number makes every key unique, so sorting is deterministic
+// and items with equal state keep their submission order.
+static const int SEQUENCE_BITS = 27;
+
+static uint64_t StateBits(const RenderState& state) {
+    return (uint64_t(state.program & 0xFFFF) << 19) |
+           (uint64_t(state.texture & 0xFFFF) << 3) |
+           (uint64_t(state.blend) << 2) |
+           (uint64_t(state.lighting) << 1) |
+           uint64_t(state.depthTest);
+}
+
+static const RenderState DEFAULT_STATE = { 0, 0, false, true, true };
+
+RenderQueue::RenderQueue()
+    : m_current(DEFAULT_STATE), m_texturing(false), m_width(1), m_height(1) {
+    m_stats.items = 0;
+    m_stats.drawCalls = 0;
+    m_stats.stateChanges = 0;
+}
+
+void RenderQueue::SetViewport(int width, int height) {
+    m_width  = width;
+    m_height = height > 0 ? height : 1;
+}
+
+void RenderQueue::Submit(RenderPass pass, const RenderState& state, ProfilePhase phase,
+                         RenderFunc draw, void* context) {
+    uint64_t sequence = m_commands.size() & ((uint64_t(1) << SEQUENCE_BITS) - 1);
+    uint64_t key = uint64_t(pass) << 62;
+    if (pass == PASS_OPAQUE) {
+        key |= (StateBits(state) << SEQUENCE_BITS) | sequence;
+    }
+    else {
+        key |= (sequence << 35) | StateBits(state);
+    }
+
+    Command command = { pass, state, phase, draw, context };
+    SortItem item = { key, static_cast<uint32_t>(m_commands.size()) };
+    m_commands.push_back(command);
+    m_order.push_back(item);
+}
+
+void RenderQueue::SetEnabled(GLenum capability, bool& current, bool wanted, bool force) {
+    if (!force && current == wanted) return;
+    if (wanted) glEnable(capability);
+    else glDisable(capability);
+    current = wanted;
+    m_stats.stateChanges++;
+}
+
+void RenderQueue::Apply(const RenderState& state, bool force) {
+    if (force || state.program != m_current.program) {
+        glUseProgram(state.program);
+        m_current.program = state.program;
+        m_stats.stateChanges++;
+    }
+
+    SetEnabled(GL_TEXTURE_2D, m_texturing, state.texture != 0, force);
+    if (state.texture != 0 && (force || state.texture != m_current.texture)) {
+        glBindTexture(GL_TEXTURE_2D, state.texture);
+        m_current.texture = state.texture;
+        m_stats.stateChanges++;
+    }
+
+    SetEnabled(GL_BLEND,      m_current.blend,     state.blend,     force);
+    SetEnabled(GL_LIGHTING,   m_current.lighting,  state.lighting,  force);
+    SetEnabled(GL_DEPTH_TEST, m_current.depthTest, state.depthTest, force);
+}
+
+void RenderQueue::Execute() {
+    m_stats.items = static_cast<int>(m_commands.size());
+    m_stats.drawCalls = 0;
+    m_stats.stateChanges = 0;
+
+    std::sort(m_order.begin(), m_order.end(),
+              [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    bool first = true;
+    bool overlay = false;
+    for (const SortItem& item : m_order) {
+        const Command& command = m_commands[item.command];
+
+        if (command.pass == PASS_OVERLAY && !overlay) {
+            // Window pixels, y down, for the rest of the frame
+            glMatrixMode(GL_PROJECTION);
+            glPushMatrix();
+            glLoadIdentity();
+            glOrtho(0, m_width, m_height, 0, -1, 1);
+            glMatrixMode(GL_MODELVIEW);
+            glPushMatrix();
+            glLoadIdentity();
+            overlay = true;
+        }
+
+        // Nothing is assumed about the state the frame starts in
+        Apply(command.state, first);
+        first = false;
+
+        ProfileScope scope(command.phase);
+        m_stats.drawCalls += command.draw(command.context);
+    }
+
+    if (overlay) {
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+    }
+
+    if (!first) {
+        Apply(DEFAULT_STATE, false);
+        if (m_current.texture != 0) {
+            glBindTexture(GL_TEXTURE_2D, 0);
+            m_current.texture = 0;
+            m_stats.stateChanges++;
+        }
+    }
+
+    Profiler::Get().Count(COUNTER_DRAW_CALLS, m_stats.drawCalls);
+    Profiler::Get().Count(COUNTER_STATE_CHANGES, m_stats.stateChanges);
+
+    m_commands.clear();
+    m_order.clear();
+}
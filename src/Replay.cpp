@@ -0,0 +1,227 @@
+#include "../include/Replay.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32_t PackKeys(const GameInput& input) {
+    uint32_t keys = 0;
+    if (input.forward)  keys |= REPLAY_KEY_FORWARD;
+    if (input.backward) keys |= REPLAY_KEY_BACKWARD;
+    if (input.left)     keys |= REPLAY_KEY_LEFT;
+    if (input.right)    keys |= REPLAY_KEY_RIGHT;
+    if (input.sprint)   keys |= REPLAY_KEY_SPRINT;
+    if (input.endGame)  keys |= REPLAY_KEY_END_GAME;
+    return keys;
+}
+
+uint64_t HashWorldState(const std::vector<uint8_t>& state) {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : state) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return hash;
+}
+
+ReplayRecorder::ReplayRecorder() : m_recording(false), m_keys(0) {
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+void ReplayRecorder::Begin(const GameWorld& world, Difficulty difficulty, uint32_t keyframeInterval) {
+    memset(&m_header, 0, sizeof(m_header));
+    memcpy(m_header.magic, "BQRP", 4);
+    m_header.version          = REPLAY_VERSION;
+    m_header.seed             = world.GetSeed();
+    m_header.difficulty       = difficulty;
+    m_header.mainCount        = world.GetMainFruits().LiveCount();
+    m_header.blackCount       = world.GetBlackFruits().LiveCount();
+    m_header.step             = SIM_STEP;
+    m_header.keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+
+    m_keys = 0;
+    m_keyframes.clear();
+    m_events.clear();
+    m_snapshots.clear();
+    m_recording = true;
+
+    AddKeyframe(world);
+}
+
+void ReplayRecorder::AddKeyframe(const GameWorld& world) {
+    ReplayKeyframe keyframe;
+    keyframe.step       = m_header.stepCount;
+    keyframe.firstEvent = static_cast<uint32_t>(m_events.size());
+    keyframe.keys       = m_keys;
+    keyframe.offset     = m_snapshots.size();
+    world.SaveState(m_snapshots);
+    keyframe.size       = static_cast<uint32_t>(m_snapshots.size() - keyframe.offset);
+    m_keyframes.push_back(keyframe);
+}
+
+void ReplayRecorder::RecordStep(const GameWorld& world, const GameInput& input) {
+    if (!m_recording) return;
+
+    const uint32_t step = m_header.stepCount;
+    if (step > 0 && step % m_header.keyframeInterval == 0) {
+        AddKeyframe(world);
+    }
+
+    uint32_t keys = PackKeys(input);
+    if (keys != m_keys || input.yawDelta != 0.0f || input.pitchDelta != 0.0f || input.speedDelta != 0.0f) {
+        m_events.push_back({ step, keys, input.yawDelta, input.pitchDelta, input.speedDelta });
+        m_keys = keys;
+    }
+
+    m_header.stepCount = step + 1;
+}
+
+bool ReplayRecorder::Finish(const GameWorld& world, const char* path) {
+    if (!m_recording) return false;
+    m_recording = false;
+
+    std::vector<uint8_t> finalState;
+    world.SaveState(finalState);
+    m_header.finalScore    = world.GetScore();
+    m_header.finalLife     = world.GetLife();
+    m_header.finalHash     = HashWorldState(finalState);
+    m_header.keyframeCount = static_cast<uint32_t>(m_keyframes.size());
+    m_header.eventCount    = static_cast<uint32_t>(m_events.size());
+
+    // Snapshots follow the index and the events
+    uint64_t base = sizeof(ReplayHeader) +
+                    m_keyframes.size() * sizeof(ReplayKeyframe) +
+                    m_events.size() * sizeof(ReplayEvent);
+    for (ReplayKeyframe& keyframe : m_keyframes) {
+        keyframe.offset += base;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(&m_header, sizeof(m_header), 1, file) == 1;
+    if (!m_keyframes.empty()) {
+        ok = ok && fwrite(m_keyframes.data(), sizeof(ReplayKeyframe), m_keyframes.size(), file) == m_keyframes.size();
+    }
+    if (!m_events.empty()) {
+        ok = ok && fwrite(m_events.data(), sizeof(ReplayEvent), m_events.size(), file) == m_events.size();
+    }
+    if (!m_snapshots.empty()) {
+        ok = ok && fwrite(m_snapshots.data(), 1, m_snapshots.size(), file) == m_snapshots.size();
+    }
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+ReplayPlayer::ReplayPlayer()
+    : m_data(nullptr), m_size(0), m_header(nullptr), m_keyframes(nullptr), m_events(nullptr),
+      m_step(0), m_nextEvent(0), m_keys(0) {
+}
+
+ReplayPlayer::~ReplayPlayer() {
+    Close();
+}
+
+bool ReplayPlayer::Open(const char* path) {
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ReplayHeader))) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = info.st_size;
+    m_header = reinterpret_cast<const ReplayHeader*>(m_data);
+
+    // Everything up to the snapshots must be in the file, and every
+    // snapshot must lie inside it
+    uint64_t tables = sizeof(ReplayHeader) +
+                      uint64_t(m_header->keyframeCount) * sizeof(ReplayKeyframe) +
+                      uint64_t(m_header->eventCount) * sizeof(ReplayEvent);
+    bool valid = memcmp(m_header->magic, "BQRP", 4) == 0 &&
+                 m_header->version == REPLAY_VERSION &&
+                 m_header->keyframeCount > 0 &&
+                 m_header->keyframeInterval > 0 &&
+                 tables <= m_size;
+    if (valid) {
+        m_keyframes = reinterpret_cast<const ReplayKeyframe*>(m_data + sizeof(ReplayHeader));
+        m_events    = reinterpret_cast<const ReplayEvent*>(m_keyframes + m_header->keyframeCount);
+        for (uint32_t i = 0; i < m_header->keyframeCount && valid; ++i) {
+            valid = m_keyframes[i].offset <= m_size && m_keyframes[i].size <= m_size - m_keyframes[i].offset &&
+                    m_keyframes[i].step == i * m_header->keyframeInterval &&
+                    m_keyframes[i].firstEvent <= m_header->eventCount;
+        }
+    }
+
+    if (!valid) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ReplayPlayer::Close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_keyframes = nullptr;
+    m_events = nullptr;
+    m_step = 0;
+    m_nextEvent = 0;
+    m_keys = 0;
+}
+
+bool ReplayPlayer::Seek(GameWorld& world, uint32_t step) {
+    if (step > m_header->stepCount) step = m_header->stepCount;
+
+    // Keyframes sit at fixed step multiples, so the index is addressed directly
+    uint32_t index = step / m_header->keyframeInterval;
+    if (index >= m_header->keyframeCount) index = m_header->keyframeCount - 1;
+    const ReplayKeyframe& keyframe = m_keyframes[index];
+
+    if (!world.LoadState(m_data + keyframe.offset, keyframe.size)) return false;
+    m_step      = keyframe.step;
+    m_nextEvent = keyframe.firstEvent;
+    m_keys      = keyframe.keys;
+
+    Advance(world, step - m_step);
+    return true;
+}
+
+uint32_t ReplayPlayer::Advance(GameWorld& world, uint32_t count) {
+    uint32_t done = 0;
+    while (done < count && m_step < m_header->stepCount) {
+        GameInput input;
+        if (m_nextEvent < m_header->eventCount && m_events[m_nextEvent].step == m_step) {
+            const ReplayEvent& event = m_events[m_nextEvent++];
+            m_keys = event.keys;
+            input.yawDelta   = event.yawDelta;
+            input.pitchDelta = event.pitchDelta;
+            input.speedDelta = event.speedDelta;
+        }
+        input.forward  = (m_keys & REPLAY_KEY_FORWARD) != 0;
+        input.backward = (m_keys & REPLAY_KEY_BACKWARD) != 0;
+        input.left     = (m_keys & REPLAY_KEY_LEFT) != 0;
+        input.right    = (m_keys & REPLAY_KEY_RIGHT) != 0;
+        input.sprint   = (m_keys & REPLAY_KEY_SPRINT) != 0;
+        input.endGame  = (m_keys & REPLAY_KEY_END_GAME) != 0;
+
+        world.Step(m_header->step, input);
+        ++m_step;
+        ++done;
+    }
+    return done;
+}
@@ -0,0 +1,96 @@
+#include "../include/Ring.h"
+#include <cmath>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Borders replace the old 5-pixel GL_LINE_LOOPs; this is about 5 pixels
+// wide at the ring's distance in the default window
+const float RING_BORDER_WIDTH = 0.012f;
+
+struct RingVertex {
+    float x, y, z;
+    float r, g, b, a;
+};
+
+// Append a closed band between two radii to a triangle strip, joined to
+// the previous band with degenerate triangles
+static void AppendBand(std::vector<RingVertex>& strip, float inner, float outer,
+                       float alpha, int segments) {
+    size_t start = strip.size();
+    for (int i = 0; i <= segments; i++) {
+        float theta = 2.0f * M_PI * float(i) / float(segments);
+        float c = cosf(theta);
+        float s = sinf(theta);
+        strip.push_back({ inner * c, inner * s, 0.0f, 1.0f, 1.0f, 0.0f, alpha });
+        strip.push_back({ outer * c, outer * s, 0.0f, 1.0f, 1.0f, 0.0f, alpha });
+    }
+
+    if (start > 0) {
+        RingVertex last  = strip[start - 1];
+        RingVertex first = strip[start];
+        strip.insert(strip.begin() + start, { last, first });
+    }
+}
+
+Ring::Ring() : m_vertexBuffer(0), m_vertexCount(0) {
+}
+
+Ring::~Ring() {
+    if (m_vertexBuffer != 0) {
+        glDeleteBuffers(1, &m_vertexBuffer);
+    }
+}
+
+void Ring::Init(float innerRadius, float outerRadius, int segments) {
+    const float alpha = 0.3f;
+    const float halfBorder = RING_BORDER_WIDTH * 0.5f;
+
+    std::vector<RingVertex> strip;
+    AppendBand(strip, innerRadius, outerRadius, alpha, segments);
+    AppendBand(strip, outerRadius - halfBorder, outerRadius + halfBorder, alpha + 0.2f, segments);
+    AppendBand(strip, innerRadius - halfBorder, innerRadius + halfBorder, alpha + 0.2f, segments);
+
+    if (m_vertexBuffer == 0) {
+        glGenBuffers(1, &m_vertexBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, strip.size() * sizeof(RingVertex), strip.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_vertexCount = static_cast<GLsizei>(strip.size());
+}
+
+void Ring::Draw(const Vector3& center, const Vector3& normal) {
+    // Orthonormal basis with the ring's z axis along the normal; the ring
+    // is symmetric about that axis, so its roll does not matter
+    Vector3 right = normal.Cross(Vector3(0.0f, 1.0f, 0.0f));
+    right.Normalize();
+    Vector3 up = right.Cross(normal);
+
+    const GLfloat model[16] = {
+        right.x,  right.y,  right.z,  0.0f,
+        up.x,     up.y,     up.z,     0.0f,
+        normal.x, normal.y, normal.z, 0.0f,
+        center.x, center.y, center.z, 1.0f
+    };
+
+    glPushMatrix();
+    glMultMatrixf(model);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RingVertex), (void*)0);
+    glColorPointer(4, GL_FLOAT, sizeof(RingVertex), (void*)(3 * sizeof(float)));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, m_vertexCount);
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glPopMatrix();
+}
@@ -0,0 +1,74 @@
+#include "../include/SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid()
+    : m_minX(0.0f), m_minZ(0.0f), m_invCellSize(1.0f), m_cols(1), m_rows(1), m_head(1, -1) {
+}
+
+void SpatialGrid::Configure(float minX, float minZ, float maxX, float maxZ, float cellSize) {
+    m_minX = minX;
+    m_minZ = minZ;
+    m_invCellSize = 1.0f / cellSize;
+    m_cols = std::max(1, static_cast<int>(std::ceil((maxX - minX) * m_invCellSize)));
+    m_rows = std::max(1, static_cast<int>(std::ceil((maxZ - minZ) * m_invCellSize)));
+    Resize(static_cast<int>(m_cell.size()));
+}
+
+void SpatialGrid::Resize(int count) {
+    m_head.assign(m_cols * m_rows, -1);
+    m_next.assign(count, -1);
+    m_prev.assign(count, -1);
+    m_cell.assign(count, -1);
+}
+
+int SpatialGrid::Column(float x) const {
+    int col = static_cast<int>(std::floor((x - m_minX) * m_invCellSize));
+    return std::min(std::max(col, 0), m_cols - 1);
+}
+
+int SpatialGrid::Row(float z) const {
+    int row = static_cast<int>(std::floor((z - m_minZ) * m_invCellSize));
+    return std::min(std::max(row, 0), m_rows - 1);
+}
+
+void SpatialGrid::Move(int index, float x, float z) {
+    int cell = Row(z) * m_cols + Column(x);
+    if (m_cell[index] == cell) return;
+
+    Remove(index);
+
+    m_cell[index] = cell;
+    m_prev[index] = -1;
+    m_next[index] = m_head[cell];
+    if (m_head[cell] != -1) {
+        m_prev[m_head[cell]] = index;
+    }
+    m_head[cell] = index;
+}
+
+void SpatialGrid::Remove(int index) {
+    int cell = m_cell[index];
+    if (cell == -1) return;
+
+    if (m_prev[index] != -1) m_next[m_prev[index]] = m_next[index];
+    else                     m_head[cell] = m_next[index];
+    if (m_next[index] != -1) m_prev[m_next[index]] = m_prev[index];
+
+    m_cell[index] = -1;
+    m_next[index] = -1;
+    m_prev[index] = -1;
+}
+
+void SpatialGrid::Query(float minX, float minZ, float maxX, float maxZ, std::vector<int>& out) const {
+    int col0 = Column(minX), col1 = Column(maxX);
+    int row0 = Row(minZ),    row1 = Row(maxZ);
+
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            for (int index = m_head[row * m_cols + col]; index != -1; index = m_next[index]) {
+                out.push_back(index);
+            }
+        }
+    }
+}
@@ -1,34 +1,211 @@
 #include "../include/Text.h"
+#include "../include/RenderQueue.h"
+#include <cstddef>
+#include <cstring>
 
-void Text::RenderText(float x, float y, const std::string& text) {
-    glPushMatrix();
-    glLoadIdentity();
+// Atlas layout: printable ASCII in a 16x6 grid of fixed cells. Helvetica 18
+// fits 18 pixels above the baseline and 5 below it.
+static void* const TEXT_FONT = GLUT_BITMAP_HELVETICA_18;
+const int GLYPH_FIRST    = 32;
+const int GLYPH_LAST     = 127;
+const int ATLAS_COLUMNS  = 16;
+const int ATLAS_ROWS     = 6;
+const int CELL_WIDTH     = 24;
+const int CELL_HEIGHT    = 24;
+const int CELL_BASELINE  = 6;    // Pixels from the bottom of a cell
+const int CELL_PAD       = 1;    // Left margin for glyphs with a negative origin
+const int ATLAS_WIDTH    = ATLAS_COLUMNS * CELL_WIDTH;
+const int ATLAS_HEIGHT   = ATLAS_ROWS * CELL_HEIGHT;
 
-    // Switch to 2D orthographic projection
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    int w = glutGet(GLUT_WINDOW_WIDTH);
-    int h = glutGet(GLUT_WINDOW_HEIGHT);
-    gluOrtho2D(0, w, h, 0);
+Text::Text()
+    : m_atlas(0), m_vertexBuffer(0), m_vertexCapacity(0) {
+    memset(m_advance, 0, sizeof(m_advance));
+}
 
-    glMatrixMode(GL_MODELVIEW);
+Text::~Text() {
+    if (m_vertexBuffer != 0) {
+        glDeleteBuffers(1, &m_vertexBuffer);
+    }
+    if (m_atlas != 0) {
+        glDeleteTextures(1, &m_atlas);
+    }
+}
+
+bool Text::Init() {
+    for (int c = GLYPH_FIRST; c < GLYPH_LAST; ++c) {
+        m_advance[c] = glutBitmapWidth(TEXT_FONT, c);
+    }
+
+    GLuint atlas = 0;
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Render the bitmap glyphs straight into the atlas texture
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &atlas);
+        return false;
+    }
+
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glViewport(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT);
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
 
-    // Position the text
-    glRasterPos2f(x, y);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, ATLAS_WIDTH, 0, ATLAS_HEIGHT, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
 
-    // Render each character
-    for (char c : text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
+    // White glyphs on transparent black; Draw() tints them per string
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    for (int c = GLYPH_FIRST; c < GLYPH_LAST; ++c) {
+        int cell = c - GLYPH_FIRST;
+        int col = cell % ATLAS_COLUMNS;
+        int row = cell / ATLAS_COLUMNS;
+        glRasterPos2i(col * CELL_WIDTH + CELL_PAD, row * CELL_HEIGHT + CELL_BASELINE);
+        glutBitmapCharacter(TEXT_FONT, c);
     }
 
-    // Restore the original projection matrix
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
-
-    glEnable(GL_DEPTH_TEST);
     glPopMatrix();
-} 
\ No newline at end of file
+    glPopAttrib();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    glDeleteFramebuffers(1, &framebuffer);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    m_atlas = atlas;
+    return true;
+}
+
+void Text::Queue(float x, float y, const char* text, float r, float g, float b) {
+    Run run;
+    run.x = x;
+    run.y = y;
+    run.r = r;
+    run.g = g;
+    run.b = b;
+    run.first = static_cast<int>(m_chars.size());
+    run.count = static_cast<int>(strlen(text));
+    m_chars.append(text, run.count);
+    m_runs.push_back(run);
+}
+
+void Text::Submit(RenderQueue& queue) {
+    if (m_runs.empty()) return;
+
+    RenderState state = { 0, m_atlas, m_atlas != 0, false, false };
+    queue.Submit(PASS_OVERLAY, state, PHASE_HUD, &Text::DrawQueued, this);
+}
+
+int Text::DrawQueued(void* context) {
+    Text* text = static_cast<Text*>(context);
+    int drawCalls = text->Draw();
+    text->m_runs.clear();
+    text->m_chars.clear();
+    return drawCalls;
+}
+
+int Text::Draw() {
+    if (m_runs.empty()) return 0;
+
+    if (m_atlas != 0) {
+        const float du = float(CELL_WIDTH)  / ATLAS_WIDTH;
+        const float dv = float(CELL_HEIGHT) / ATLAS_HEIGHT;
+
+        m_vertices.clear();
+        for (const Run& run : m_runs) {
+            GLubyte r = static_cast<GLubyte>(run.r * 255.0f + 0.5f);
+            GLubyte g = static_cast<GLubyte>(run.g * 255.0f + 0.5f);
+            GLubyte b = static_cast<GLubyte>(run.b * 255.0f + 0.5f);
+            float top    = run.y - (CELL_HEIGHT - CELL_BASELINE);
+            float bottom = run.y + CELL_BASELINE;
+            float pen    = run.x;
+
+            for (int i = 0; i < run.count; ++i) {
+                int c = static_cast<unsigned char>(m_chars[run.first + i]);
+                if (c < GLYPH_FIRST || c >= GLYPH_LAST) continue;
+
+                int cell = c - GLYPH_FIRST;
+                float u0 = (cell % ATLAS_COLUMNS) * du;
+                float v0 = (cell / ATLAS_COLUMNS) * dv;
+                float left = pen - CELL_PAD;
+                float right = left + CELL_WIDTH;
+
+                // Texture rows run bottom-up, screen rows top-down
+                m_vertices.push_back({ left,  bottom, u0,      v0,      r, g, b, 255 });
+                m_vertices.push_back({ right, bottom, u0 + du, v0,      r, g, b, 255 });
+                m_vertices.push_back({ right, top,    u0 + du, v0 + dv, r, g, b, 255 });
+                m_vertices.push_back({ left,  top,    u0,      v0 + dv, r, g, b, 255 });
+
+                pen += m_advance[c];
+            }
+        }
+
+        if (!m_vertices.empty()) {
+            // Orphan last frame's storage so the upload never waits on the GPU
+            GLsizeiptr bytes = m_vertices.size() * sizeof(GlyphVertex);
+            glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+            if (bytes > m_vertexCapacity) {
+                m_vertexCapacity = bytes * 2;
+            }
+            glBufferData(GL_ARRAY_BUFFER, m_vertexCapacity, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_vertices.data());
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glEnableClientState(GL_COLOR_ARRAY);
+            glVertexPointer(2, GL_FLOAT, sizeof(GlyphVertex), (void*)offsetof(GlyphVertex, x));
+            glTexCoordPointer(2, GL_FLOAT, sizeof(GlyphVertex), (void*)offsetof(GlyphVertex, u));
+            glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(GlyphVertex), (void*)offsetof(GlyphVertex, r));
+
+            glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(m_vertices.size()));
+
+            glDisableClientState(GL_COLOR_ARRAY);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return 1;
+        }
+        return 0;
+    }
+    return DrawBitmap();
+}
+
+int Text::DrawBitmap() {
+    int drawCalls = 0;
+    for (const Run& run : m_runs) {
+        glColor3f(run.r, run.g, run.b);
+        glRasterPos2f(run.x, run.y);
+        for (int i = 0; i < run.count; ++i) {
+            glutBitmapCharacter(TEXT_FONT, m_chars[run.first + i]);
+        }
+        drawCalls += run.count;
+    }
+    return drawCalls;
+}
@@ -1,7 +1,16 @@
 #include "../include/Texture.h"
+#include "../include/DdsFormat.h"
 #include <iostream>
-#include <fstream>
 #include <cstring>
+#include <strings.h>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Bitmap file header structure
 #pragma pack(1)
@@ -27,87 +36,322 @@ typedef struct {
 } BMPInfoHeader;
 #pragma pack()
 
-CTexture::CTexture() : m_textureID(0), m_width(0), m_height(0), m_imageData(nullptr) {
+const unsigned int BMP_RGB       = 0;   // Uncompressed
+const unsigned int BMP_BITFIELDS = 3;   // Uncompressed with channel masks (32-bit)
+
+// Shared textures by canonical path
+struct TextureEntry {
+    GLuint id;
+    int    width;
+    int    height;
+    int    refs;
+};
+
+static std::unordered_map<std::string, TextureEntry>& TextureCache() {
+    // Never destroyed: global CTextures release into it during exit
+    static std::unordered_map<std::string, TextureEntry>* cache =
+        new std::unordered_map<std::string, TextureEntry>();
+    return *cache;
+}
+
+CTexture::CTexture() : m_textureID(0), m_width(0), m_height(0) {
 }
 
 CTexture::~CTexture() {
-    if (m_imageData) {
-        delete[] m_imageData;
+    Release();
+}
+
+const unsigned char* MapTextureFile(const char* filename, size_t& fileSize) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Couldn't open the file " << filename << std::endl;
+        return nullptr;
     }
-    if (m_textureID != 0) {
-        glDeleteTextures(1, &m_textureID);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        std::cerr << "Error: Couldn't read the file " << filename << std::endl;
+        close(fd);
+        return nullptr;
+    }
+
+    fileSize = info.st_size;
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: Couldn't map the file " << filename << std::endl;
+        return nullptr;
     }
+    return static_cast<const unsigned char*>(mapping);
+}
+
+void UnmapTextureFile(const unsigned char* data, size_t fileSize) {
+    munmap(const_cast<unsigned char*>(data), fileSize);
+}
+
+// Pointer arithmetic that also works when base is a buffer offset (null)
+static const GLvoid* PixelsAt(const unsigned char* base, size_t offset) {
+    return reinterpret_cast<const GLvoid*>(reinterpret_cast<uintptr_t>(base) + offset);
 }
 
-int LoadBitmap(char* filename) {
+bool ParseBitmap(const char* filename, const unsigned char* data, size_t size, TextureImage& image) {
+    if (size < sizeof(BMPHeader) + sizeof(BMPInfoHeader)) {
+        std::cerr << "Error: Not a valid bitmap file " << filename << std::endl;
+        return false;
+    }
+
     BMPHeader header;
     BMPInfoHeader infoHeader;
-    GLuint texture;
+    memcpy(&header, data, sizeof(header));
+    memcpy(&infoHeader, data + sizeof(header), sizeof(infoHeader));
 
-    // Open the file
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Couldn't open the file " << filename << std::endl;
-        return -1;
+    // Check the headers: uncompressed 24- or 32-bit, rows padded to 4 bytes,
+    // and every row inside the file
+    int rows = infoHeader.height < 0 ? -infoHeader.height : infoHeader.height;
+    int bytesPerPixel = infoHeader.bits / 8;
+    bool valid = header.type == 0x4D42 &&   // 'BM' in hex
+                 infoHeader.size >= sizeof(BMPInfoHeader) &&
+                 infoHeader.planes == 1 &&
+                 (infoHeader.bits == 24 || infoHeader.bits == 32) &&
+                 (infoHeader.compression == BMP_RGB ||
+                  (infoHeader.compression == BMP_BITFIELDS && infoHeader.bits == 32)) &&
+                 infoHeader.width > 0 && infoHeader.width <= INT_MAX / 4 && rows > 0;
+
+    size_t stride = 0;
+    if (valid) {
+        stride = (static_cast<size_t>(infoHeader.width) * bytesPerPixel + 3) & ~size_t(3);
+        valid = header.offset <= size && stride * rows <= size - header.offset;
+    }
+    if (!valid) {
+        std::cerr << "Error: Not a valid bitmap file " << filename << std::endl;
+        return false;
     }
 
-    // Read the headers
-    file.read(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
-    file.read(reinterpret_cast<char*>(&infoHeader), sizeof(BMPInfoHeader));
+    // BMP rows are 4-byte aligned, which is GL's default unpack alignment,
+    // and stored blue first, so the file's pixels go to GL untouched
+    image.width          = infoHeader.width;
+    image.height         = rows;
+    image.compressed     = false;
+    image.internalFormat = bytesPerPixel == 4 ? GL_RGBA8 : GL_RGB8;
+    image.format         = bytesPerPixel == 4 ? GL_BGRA : GL_BGR;
+    image.topDown        = infoHeader.height < 0;
+    image.stride         = stride;
+    image.payloadOffset  = header.offset;
+    image.payloadSize    = stride * rows;
+    image.levels.assign(1, TextureLevel{ image.width, rows, 0, image.payloadSize });
+    return true;
+}
 
-    // Check if it's a valid bitmap file
-    if (header.type != 0x4D42) { // 'BM' in hex
-        std::cerr << "Error: Not a valid bitmap file" << std::endl;
-        file.close();
-        return -1;
+bool ParseDds(const char* filename, const unsigned char* data, size_t size, TextureImage& image) {
+    uint32_t magic = 0;
+    DdsHeader header;
+    memset(&header, 0, sizeof(header));
+    if (size >= 4 + sizeof(DdsHeader)) {
+        memcpy(&magic, data, 4);
+        memcpy(&header, data + 4, sizeof(header));
     }
 
-    // Allocate memory for the image data
-    int imageSize = infoHeader.width * infoHeader.height * 3;
-    unsigned char* imageData = new unsigned char[imageSize];
+    // Only what the converter writes: a 2D DXT1 or 32-bit BGRA mip chain
+    bool dxt1 = (header.format.flags & DDPF_FOURCC) && header.format.fourCC == DDS_FOURCC_DXT1;
+    bool bgra = (header.format.flags & DDPF_RGB) && header.format.rgbBitCount == 32 &&
+                header.format.rMask == 0x00FF0000 && header.format.gMask == 0x0000FF00 &&
+                header.format.bMask == 0x000000FF;
+    uint32_t levels = (header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+    bool valid = magic == DDS_MAGIC && header.size == sizeof(DdsHeader) &&
+                 header.format.size == sizeof(DdsPixelFormat) && (dxt1 || bgra) &&
+                 header.width > 0 && header.width <= 32768 &&
+                 header.height > 0 && header.height <= 32768 &&
+                 levels <= DdsMipCount(header.width, header.height);
 
-    // Seek to the image data
-    file.seekg(header.offset, std::ios::beg);
+    // Every level has to be inside the file
+    image.levels.clear();
+    size_t total = 0;
+    for (uint32_t i = 0, w = header.width, h = header.height; valid && i < levels; ++i) {
+        size_t levelSize = DdsLevelSize(dxt1, w, h);
+        image.levels.push_back(TextureLevel{ static_cast<int>(w), static_cast<int>(h), total, levelSize });
+        total += levelSize;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    valid = valid && total <= size - 4 - sizeof(DdsHeader);
+    if (!valid) {
+        std::cerr << "Error: Not a supported DDS file " << filename << std::endl;
+        return false;
+    }
 
-    // Read the image data
-    file.read(reinterpret_cast<char*>(imageData), imageSize);
+    image.width          = header.width;
+    image.height         = header.height;
+    image.compressed     = dxt1;
+    image.internalFormat = dxt1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8;
+    image.format         = GL_BGRA;
+    image.topDown        = false;
+    image.stride         = 0;
+    image.payloadOffset  = 4 + sizeof(DdsHeader);
+    image.payloadSize    = total;
+    return true;
+}
 
-    // Close the file
-    file.close();
+bool ParseTextureFile(const char* filename, const unsigned char* data, size_t size, TextureImage& image) {
+    size_t length = strlen(filename);
+    if (length > 4 && strcasecmp(filename + length - 4, ".dds") == 0) {
+        return ParseDds(filename, data, size, image);
+    }
+    return ParseBitmap(filename, data, size, image);
+}
 
-    // Convert BGR to RGB
-    for (int i = 0; i < imageSize; i += 3) {
-        unsigned char temp = imageData[i];
-        imageData[i] = imageData[i + 2];
-        imageData[i + 2] = temp;
+GLuint UploadTextureImage(const TextureImage& image, const unsigned char* pixels) {
+    if (image.compressed) {
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        if (!(extensions && strstr(extensions, "GL_EXT_texture_compression_s3tc"))) {
+            std::cerr << "Error: DXT1 textures not supported by this driver" << std::endl;
+            return 0;
+        }
     }
 
     // Generate and bind texture
+    GLuint texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // Set texture parameters; trilinear when there is a mip chain
+    int levels = static_cast<int>(image.levels.size());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
 
-    // Create the texture
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, infoHeader.width, infoHeader.height,
-                 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
 
-    // Free the image data
-    delete[] imageData;
+    // Levels go straight to GL, largest first
+    for (int i = 0; i < levels; ++i) {
+        const TextureLevel& level = image.levels[i];
+        if (image.compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, image.internalFormat, level.width, level.height,
+                                   0, static_cast<GLsizei>(level.size), PixelsAt(pixels, level.offset));
+        }
+        else if (!image.topDown) {
+            // Bottom-up rows, same as GL's texture origin
+            glTexImage2D(GL_TEXTURE_2D, i, image.internalFormat, level.width, level.height,
+                         0, image.format, GL_UNSIGNED_BYTE, PixelsAt(pixels, level.offset));
+        }
+        else {
+            // Top-down file: upload row by row into flipped positions
+            glTexImage2D(GL_TEXTURE_2D, i, image.internalFormat, level.width, level.height,
+                         0, image.format, GL_UNSIGNED_BYTE, nullptr);
+            for (int row = 0; row < level.height; ++row) {
+                glTexSubImage2D(GL_TEXTURE_2D, i, 0, level.height - 1 - row, level.width, 1, image.format,
+                                GL_UNSIGNED_BYTE, PixelsAt(pixels, level.offset + row * image.stride));
+            }
+        }
+    }
 
+    glPopClientAttrib();
     return texture;
 }
 
+// Map, parse and upload in place
+static GLuint LoadMapped(const char* filename, bool dds, int* width, int* height) {
+    size_t fileSize = 0;
+    const unsigned char* data = MapTextureFile(filename, fileSize);
+    if (!data) return 0;
+
+    TextureImage image;
+    GLuint texture = 0;
+    bool parsed = dds ? ParseDds(filename, data, fileSize, image)
+                      : ParseBitmap(filename, data, fileSize, image);
+    if (parsed) {
+        texture = UploadTextureImage(image, data + image.payloadOffset);
+    }
+    UnmapTextureFile(data, fileSize);
+
+    if (texture != 0) {
+        if (width)  *width  = image.width;
+        if (height) *height = image.height;
+    }
+    return texture;
+}
+
+GLuint LoadBitmap(const char* filename, int* width, int* height) {
+    return LoadMapped(filename, false, width, height);
+}
+
+GLuint LoadDds(const char* filename, int* width, int* height) {
+    return LoadMapped(filename, true, width, height);
+}
+
+std::string CTexture::CacheKey(const char* filename) {
+    // Key on the resolved path so different spellings share one texture
+    char resolved[PATH_MAX];
+    return realpath(filename, resolved) ? resolved : filename;
+}
+
 bool CTexture::LoadTexture(const char* filename) {
-    // Delete existing texture if any
-    if (m_textureID != 0) {
-        glDeleteTextures(1, &m_textureID);
+    std::string key = CacheKey(filename);
+    if (key == m_key) return m_textureID != 0;
+    if (Acquire(key)) return true;
+
+    size_t length = strlen(filename);
+    bool dds = length > 4 && strcasecmp(filename + length - 4, ".dds") == 0;
+    int width = 0, height = 0;
+    GLuint id = LoadMapped(filename, dds, &width, &height);
+    if (id == 0) return false;
+
+    Adopt(key, id, width, height);
+    return true;
+}
+
+bool CTexture::Acquire(const std::string& key) {
+    if (key == m_key) return m_textureID != 0;
+
+    std::unordered_map<std::string, TextureEntry>& cache = TextureCache();
+    auto it = cache.find(key);
+    if (it == cache.end()) return false;
+
+    // Drop the texture currently held, if any
+    Release();
+    it->second.refs++;
+    m_textureID = it->second.id;
+    m_width     = it->second.width;
+    m_height    = it->second.height;
+    m_key       = key;
+    return true;
+}
+
+void CTexture::Adopt(const std::string& key, GLuint id, int width, int height) {
+    // Someone else got the same file in first: keep theirs
+    std::unordered_map<std::string, TextureEntry>& cache = TextureCache();
+    if (cache.count(key) != 0) {
+        glDeleteTextures(1, &id);
+        Acquire(key);
+        return;
     }
 
-    m_textureID = LoadBitmap(const_cast<char*>(filename));
-    return m_textureID != -1;
+    Release();
+    TextureEntry entry = { id, width, height, 1 };
+    cache.emplace(key, entry);
+    m_textureID = id;
+    m_width     = width;
+    m_height    = height;
+    m_key       = key;
+}
+
+void CTexture::Release() {
+    if (m_key.empty()) return;
+
+    std::unordered_map<std::string, TextureEntry>& cache = TextureCache();
+    auto it = cache.find(m_key);
+    if (it != cache.end() && --it->second.refs == 0) {
+        glDeleteTextures(1, &it->second.id);
+        cache.erase(it);
+    }
+
+    m_textureID = 0;
+    m_width = 0;
+    m_height = 0;
+    m_key.clear();
 }
 
 void CTexture::BindTexture() {
@@ -118,4 +362,4 @@ void CTexture::BindTexture() {
 
 void CTexture::UnbindTexture() {
     glBindTexture(GL_TEXTURE_2D, 0);
-} 
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#include "../include/UdpSocket.h"
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpSocket::UdpSocket() : m_fd(-1) {
+}
+
+UdpSocket::~UdpSocket() {
+    Close();
+}
+
+bool UdpSocket::Open(uint16_t port, int bufferBytes) {
+    Close();
+    m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_fd < 0) return false;
+
+    setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::Close() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool UdpSocket::Send(const sockaddr_in& to, const void* data, size_t size) {
+    ssize_t sent = sendto(m_fd, data, size, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+    return sent == static_cast<ssize_t>(size);
+}
+
+int UdpSocket::Receive(void* buffer, size_t capacity, sockaddr_in* from) {
+    socklen_t length = sizeof(sockaddr_in);
+    ssize_t size = recvfrom(m_fd, buffer, capacity, 0, reinterpret_cast<sockaddr*>(from), &length);
+    return size < 0 ? -1 : static_cast<int>(size);
+}
+
+bool UdpSocket::Wait(int timeoutMs) {
+    pollfd entry = { m_fd, POLLIN, 0 };
+    return poll(&entry, 1, timeoutMs) > 0;
+}
+
+bool ResolveAddress(const char* host, uint16_t defaultPort, sockaddr_in& out) {
+    std::string name = host;
+    uint16_t port = defaultPort;
+    size_t colon = name.rfind(':');
+    if (colon != std::string::npos) {
+        port = static_cast<uint16_t>(atoi(name.c_str() + colon + 1));
+        name.resize(colon);
+    }
+
+    memset(&out, 0, sizeof(out));
+    out.sin_family = AF_INET;
+    out.sin_port = htons(port);
+    if (inet_pton(AF_INET, name.c_str(), &out.sin_addr) == 1) return true;
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(name.c_str(), nullptr, &hints, &result) != 0 || !result) return false;
+    out.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
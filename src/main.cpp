@@ -4,13 +4,25 @@
 #include <ctime>
 #include <cstdlib>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
 #include <GL/glut.h>
 #include "../include/Camera.h"
-#include "../include/Fruit.h"
 #include "../include/Texture.h"
+#include "../include/AssetLoader.h"
 #include "../include/Text.h"
+#include "../include/GameWorld.h"
+#include "../include/BallRenderer.h"
+#include "../include/Ring.h"
+#include "../include/Arena.h"
+#include "../include/Profiler.h"
+#include "../include/Replay.h"
+#include "../include/RenderQueue.h"
+#include "../include/JobSystem.h"
+#include "../include/OffscreenContext.h"
+#include "../include/FrameCapture.h"
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -22,35 +34,58 @@ using namespace std;
 const int WINDOW_WIDTH  = 1280;
 const int WINDOW_HEIGHT = 720;
 
+// Context for --render-bench; defined before anything holding GL objects
+// so it outlives them at exit
+OffscreenContext offscreen;
+
 // Ground and walls
-const float GROUND_SIZE = 50.0f;
-const float GROUND_Y    = 0.0f;
 const float WALL_HEIGHT = 30.0f;
-const float WALL_DISTANCE = GROUND_SIZE;
-CTexture wallTexture;
+const int   ARENA_TESSELLATION = 32;   // Grid cells per side of each face
+CTexture wallTexture;   // Filled in by assets once it has loaded
+Arena    arena;
+
+// Background texture loading
+AssetLoader assets;
+
+// Simulation state (score, lives, fruits, player)
+GameWorld world;
+int threadCount = 0;   // --threads N for the ball simulation, 0 for one per core
+
+// Fixed-step timing: the world advances in SIM_STEP increments and frames
+// draw renderAlpha of the way from the previous step to the current one
+float   simAccumulator = 0.0f;
+float   renderAlpha    = 0.0f;
+Vector3 prevPosition;   // Player pose before the last step
+Vector3 prevView;
+
+// Balls
+BallRenderer ballRenderer;
+int ballCountOverride = 0;   // --balls N replaces the per-difficulty counts
 
 // Camera
 CCamera camera;
 
+// Draw items for the current frame, sorted by state before they run
+RenderQueue renderQueue;
+
 // HUD & Score
 Text    scoreText;
-int     score = 0;
-int     life  = 20;
-
-// Fruit related
-const int  BallHeight = 50;
-const int  Interval   = 20;
-
-// Basket
-const float BASKET_RADIUS   = 0.1f;
-const float BASKET_HEIGHT   = 0.1f;
-const int   BASKET_SEGMENTS = 32;
-Vector3 basketPosition(0.0f, 1.0f, 0.0f);
-
-// Ring and scoring area
-const float CATCH_DISTANCE = 0.8f;
-const float RING_RADIUS = CATCH_DISTANCE;
+char    scoreLine[64];   // Formatted in place every frame
+char    timeLine[64];
+
+// Profiler overlay (P) and CSV export on exit (--profile-csv FILE)
+const int   PROFILER_WINDOW = 240;   // Frames in the rolling statistics
+bool        showProfiler    = false;
+const char* profileCsvPath  = nullptr;
+char        profilerCells[PHASE_COUNT + 1][3][32];
+char        profilerCounts[64];
+char        profilerCulling[64];
+int         ballsDrawn      = 0;   // Frustum culling results, last frame
+int         ballsCulled     = 0;
+
+// Ring
 const int   RING_SEGMENTS = 50;
+Ring        catchRing;
 
 // Mouse and keyboard input
 bool keyStates[256] = {false};
@@ -58,8 +93,28 @@ bool specialKeyStates[256] = {false};
 int  lastMouseX = WINDOW_WIDTH / 2;
 int  lastMouseY = WINDOW_HEIGHT / 2;
 bool firstMouse = true;
-float yaw   = -90.0f;
-float pitch = 0.0f;
+float pendingYaw   = 0.0f;   // Mouse look accumulated until the next step
+float pendingPitch = 0.0f;
+float pendingSpeed = 0.0f;   // +/- presses, applied by the next step
+bool  pendingEndGame = false;
+
+// Offscreen render benchmark (--render-bench FRAMES): a fixed scene and
+// camera path drawn into a framebuffer object as fast as possible. GLUT
+// fonts need a window system, so the HUD is left out.
+const uint32_t RENDER_BENCH_SEED   = 1;
+const int      RENDER_BENCH_WARMUP = 30;    // Frames drawn before timing starts
+const int      RENDER_BENCH_ORBIT  = 720;   // Frames per lap of the camera path
+int  renderBenchFrames = 0;
+bool showHud           = true;
+
+// Frame capture (--capture DIR, or - for raw RGB on stdout)
+FrameCapture frameCapture;
+const char*  capturePath = nullptr;
+
+// Replay recording (--record FILE)
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 600;   // Steps, 5 seconds at 120 Hz
+ReplayRecorder recorder;
+const char*    recordPath = nullptr;
 
 // Game state & difficulty
 enum GameState {
@@ -67,11 +122,6 @@ enum GameState {
     PLAYING,
     GAMEOVER
 };
-enum Difficulty {
-    EASY,
-    MEDIUM,
-    HARD
-};
 
 // Menu button structure
 struct Button {
@@ -88,22 +138,9 @@ vector<Button> difficultyButtons = {
 };
 
 GameState   currentState        = MENU;
-Difficulty  selectedDifficulty  = MEDIUM;
-
-// Game timing and parameters
-float gameTime          = 0.0f;
-const float GAME_DURATION = 120.0f;
-float gameOverStartTime = 0.0f;
 
-// Speed and sensitivity parameters
-float cameraSpeed         = 0.1f;
+// Sensitivity parameters
 float mouseSensitivity    = 0.05f;
-float fruitSpeedMultiplier = 1.0f;
-
-// Explosion effect
-float explosionTime = 0.0f;
-bool isExploding = false;
-const float EXPLOSION_DURATION = 2.0f;
 
 // Function declarations
 void init();
@@ -118,31 +155,27 @@ void mouseMotion(int x, int y);
 void passiveMotion(int x, int y);
 
 void createGroundAndWalls();
+void cullBalls();
+void renderScene();
+int  runRenderBenchmark();
 void drawMenu();
-void drawButton(const Button& btn);
+void submitButton(const Button& btn);
+int  drawButton(void* context);
 void startGame(Difficulty diff);
-
-void processKeys();
-void checkCollisions();
-void drawRing();
-
-// Global fruit containers
-vector<Fruit> mainFruits;
-vector<Fruit> blackFruits;
-
-// Initialize fruits with default positions
-void InitializeFruits() {
-    // Generate initial main fruits
-    for (int i = 0; i < 5; ++i) {
-        Vector3 pos(0.0f, 0.0f, 0.0f);
-        mainFruits.emplace_back(pos, FruitType::MAIN);
-    }
-    // Generate initial black balls
-    for (int i = 0; i < 3; ++i) {
-        Vector3 pos(0.0f, 0.0f, 0.0f);
-        blackFruits.emplace_back(pos, FruitType::BLACK);
-    }
-}
+void splitBallCount(int total, int& mainCount, int& blackCount);
+
+GameInput processKeys();
+void syncCamera(float alpha);
+void resetInterpolation();
+int  drawRing(void* context);
+int  drawFallbackBalls(void* context);
+int  drawExplosion(void* context);
+void drawProfiler();
+void exportProfile();
+void finishRecording();
+void captureFrame();
+void finishCapture();
+void shutdownAssets();
 
 void initializeGLUT(int argc, char** argv) {
     glutInit(&argc, argv);
@@ -163,14 +196,59 @@ void setupCallbacks() {
 }
 
 int main(int argc, char** argv) {
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--balls") == 0) {
+            ballCountOverride = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--profile-csv") == 0) {
+            profileCsvPath = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--record") == 0) {
+            recordPath = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--render-bench") == 0) {
+            renderBenchFrames = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--capture") == 0) {
+            capturePath = argv[i + 1];
+        }
+    }
+
+    static JobSystem jobs(threadCount);
+    world.SetJobSystem(&jobs);
+
+    // Room for the densest round up front, so no round allocates balls
+    if (ballCountOverride > 0) {
+        int mainCount, blackCount;
+        splitBallCount(ballCountOverride, mainCount, blackCount);
+        world.ReserveFruits(mainCount, blackCount);
+    }
+    else {
+        SpawnSchedule hard = DefaultSpawnSchedule(HARD);   // Densest of the three
+        world.ReserveFruits(hard.mainPeak, hard.blackPeak);
+    }
+
+    Profiler::Get().SetEnabled(true);
+    atexit(exportProfile);
+    atexit(finishRecording);
+    atexit(finishCapture);
+    atexit(shutdownAssets);
+
+    if (renderBenchFrames > 0) {
+        return runRenderBenchmark();
+    }
+
     // Initialize GLUT and create window
     initializeGLUT(argc, argv);
 
     // Initialize OpenGL settings and game state
     init();
-
-    // Initialize game objects
-    InitializeFruits();
+    if (capturePath && !frameCapture.Start(capturePath, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return 1;
+    }
 
     // Set up callback functions
     setupCallbacks();
@@ -188,7 +266,15 @@ void init() {
     glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
     glEnable(GL_DEPTH_TEST);
 
-    wallTexture.LoadTexture("../textures/wall.bmp");
+    // Prefer the mipmapped DDS the build converts; the BMP still works.
+    // Loads in the background while the menu is up.
+    assets.LoadTexture(&wallTexture, "textures/wall.dds", "../textures/wall.bmp");
+    ballRenderer.Init();
+    if (showHud) {
+        scoreText.Init();
+    }
+    catchRing.Init(RING_RADIUS * 0.8f, RING_RADIUS, RING_SEGMENTS);
+    arena.Init(GROUND_SIZE, GROUND_Y, WALL_HEIGHT, ARENA_TESSELLATION);
 
     glEnable(GL_LIGHTING);
     glEnable(GL_LIGHT0);
@@ -202,16 +288,7 @@ void init() {
     glLightfv(GL_LIGHT0, GL_AMBIENT,  lightAmbient);
     glLightfv(GL_LIGHT0, GL_DIFFUSE,  lightDiffuse);
 
-    camera.PositionCamera(
-        0.0f, 2.0f, 6.0f,
-        0.0f, 0.0f, 0.0f,
-        0.0f, 1.0f, 0.0f
-    );
-    
-    srand(static_cast<unsigned>(time(nullptr)));
-
-    gameTime          = 0.0f;
-    gameOverStartTime = 0.0f;
+    resetInterpolation();
 }
 
 void reshape(int w, int h) {
@@ -223,6 +300,13 @@ void reshape(int w, int h) {
     glLoadIdentity();
     gluPerspective(45.0f, ratio, 0.1f, 1000.0f);
     glMatrixMode(GL_MODELVIEW);
+
+    renderQueue.SetViewport(w, h);
+
+    // Read back the whole resized framebuffer, not the startup size
+    if (frameCapture.IsActive()) {
+        frameCapture.Resize(w, h);
+    }
 }
 
 void display() {
@@ -235,148 +319,115 @@ void display() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glLoadIdentity();
 
-        glDisable(GL_LIGHTING);
-        glColor3f(1.0f, 0.0f, 0.0f);
-        string gameOverText    = "Game Over";
-        string finalScoreText  = "Final Score: " + to_string(score);
-
-        scoreText.RenderText(WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2,     gameOverText);
-        glColor3f(1.0f, 1.0f, 1.0f);
-        scoreText.RenderText(WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2 - 40, finalScoreText);
+        snprintf(scoreLine, sizeof(scoreLine), "Final Score: %d", world.GetScore());
+        scoreText.Queue(WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2,      "Game Over", 1.0f, 0.0f, 0.0f);
+        scoreText.Queue(WINDOW_WIDTH / 2 - 80, WINDOW_HEIGHT / 2 - 40, scoreLine,   1.0f, 1.0f, 1.0f);
+        scoreText.Submit(renderQueue);
+        renderQueue.Execute();
 
         glutSwapBuffers();
         return;
     }
 
+    renderScene();
+    captureFrame();
+
+    glutSwapBuffers();
+    Profiler::Get().EndFrame();
+}
+
+// Queue and draw one frame of the game at the current camera
+void renderScene() {
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 
     camera.Look();
 
+    // Everything below only submits; the queue draws it sorted by state
     createGroundAndWalls();
-    drawRing();
 
-    for (auto& fruit : mainFruits) {
-        fruit.Draw();
-    }
+    RenderState ringState = { 0, 0, true, false, true };
+    renderQueue.Submit(PASS_TRANSLUCENT, ringState, PHASE_RING, drawRing, nullptr);
 
-    for (auto& fruit : blackFruits) {
-        fruit.Draw();
+    cullBalls();
+    if (ballRenderer.IsAvailable()) {
+        ballRenderer.Submit(renderQueue, world.GetMainFruits(), world.GetBlackFruits(),
+                            camera.m_vPosition, renderAlpha);
+    }
+    else {
+        RenderState ballState = { 0, 0, false, true, true };
+        renderQueue.Submit(PASS_OPAQUE, ballState, PHASE_BALLS, drawFallbackBalls, nullptr);
     }
 
-    glDisable(GL_LIGHTING);
-    glColor3f(0.0f, 0.0f, 0.0f);
-
-    stringstream ss;
-    ss << "Score: " << score << "  Life: " << life;
-    scoreText.RenderText(10, 30, ss.str());
-
-    float remainingTime = GAME_DURATION - gameTime;
-    if (remainingTime < 0.0f) remainingTime = 0.0f;
-    stringstream timeSS;
-    timeSS << fixed << setprecision(1) << "Time: " << remainingTime << " sec";
-    scoreText.RenderText(10, 60, timeSS.str());
-
-    glEnable(GL_LIGHTING);
+    if (showHud) {
+        snprintf(scoreLine, sizeof(scoreLine), "Score: %d  Life: %d", world.GetScore(), world.GetLife());
+        snprintf(timeLine, sizeof(timeLine), "Time: %.1f sec", world.GetRemainingTime());
+        scoreText.Queue(10, 30, scoreLine, 0.0f, 0.0f, 0.0f);
+        scoreText.Queue(10, 60, timeLine,  0.0f, 0.0f, 0.0f);
+        if (showProfiler) {
+            drawProfiler();
+        }
+        scoreText.Submit(renderQueue);
+    }
 
-    if (isExploding) {
-        glDisable(GL_LIGHTING);
-        glDisable(GL_DEPTH_TEST);
-        
-        float alpha = 1.0f - (explosionTime / EXPLOSION_DURATION);
-        if (alpha < 0.0f) alpha = 0.0f;
-        
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glColor4f(0.0f, 0.0f, 0.0f, alpha);
-        
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
-        glLoadIdentity();
-        glOrtho(0, WINDOW_WIDTH, WINDOW_HEIGHT, 0, -1, 1);
-        
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-        
-        glBegin(GL_QUADS);
-            glVertex2f(0, 0);
-            glVertex2f(WINDOW_WIDTH, 0);
-            glVertex2f(WINDOW_WIDTH, WINDOW_HEIGHT);
-            glVertex2f(0, WINDOW_HEIGHT);
-        glEnd();
-        
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();
-        glMatrixMode(GL_MODELVIEW);
-        glPopMatrix();
-        
-        glDisable(GL_BLEND);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_LIGHTING);
+    // Fade to black over the HUD
+    if (world.IsExploding()) {
+        RenderState fadeState = { 0, 0, true, false, false };
+        renderQueue.Submit(PASS_OVERLAY, fadeState, PHASE_HUD, drawExplosion, nullptr);
     }
 
-    glutSwapBuffers();
+    renderQueue.Execute();
 }
 
 void update() {
-    static float lastTime = 0.0f;
-    float currentTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f; // 轉秒
-    float deltaTime   = currentTime - lastTime;
-    lastTime          = currentTime;
+    typedef std::chrono::steady_clock Clock;
+    static Clock::time_point lastTime = Clock::now();
+    Clock::time_point currentTime = Clock::now();
+    float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
+    lastTime        = currentTime;
+
+    assets.Poll();
 
     if (currentState == MENU || currentState == GAMEOVER) {
         glutPostRedisplay();
         return;
     }
 
-    if (isExploding) {
-        explosionTime += deltaTime;
-        if (explosionTime >= EXPLOSION_DURATION) {
-            isExploding = false;
-            explosionTime = 0.0f;
+    // Run whole simulation steps for the elapsed time. Mouse look goes to
+    // the first step; later ones only see the held keys.
+    simAccumulator += deltaTime;
+    int steps = 0;
+    while (simAccumulator >= SIM_STEP && steps < MAX_CATCHUP_STEPS && !world.IsOver()) {
+        prevPosition = world.GetPosition();
+        prevView     = world.GetView();
+        GameInput input;
+        {
+            ProfileScope scope(PHASE_INPUT);
+            input = processKeys();
+        }
+        recorder.RecordStep(world, input);
+        world.Step(SIM_STEP, input);
+        simAccumulator -= SIM_STEP;
+        ++steps;
+
+        if (input.speedDelta != 0.0f) {
+            cout << "Camera Speed: " << world.GetCameraSpeed()
+                 << ", Fruit Speed Multiplier: " << world.GetFruitSpeedMultiplier() << endl;
         }
     }
 
-    gameTime += deltaTime;
-    if (gameTime >= GAME_DURATION) {
-        currentState       = GAMEOVER;
-        gameOverStartTime  = currentTime;
-        return;
-    }
-
-    processKeys();
-
-    Vector3 forward = camera.m_vView - camera.m_vPosition;
-    forward.y = 0;
-    forward.Normalize();
-    forward = forward * 0.7f;
-
-    basketPosition.x = camera.m_vPosition.x + forward.x;
-    basketPosition.z = camera.m_vPosition.z + forward.z;
-    basketPosition.y = camera.m_vPosition.y + 0.1f;
-
-    for (auto& fruit : mainFruits) {
-        fruit.Update(deltaTime * fruitSpeedMultiplier); 
-    }
-
-    for (auto& fruit : blackFruits) {
-        fruit.Update(deltaTime * fruitSpeedMultiplier); 
+    // After a hitch, drop the backlog instead of spiralling
+    if (simAccumulator >= SIM_STEP) {
+        simAccumulator = fmodf(simAccumulator, SIM_STEP);
     }
 
-    checkCollisions();
-
-    for (auto& fruit : mainFruits) {
-        if (!fruit.IsActive()) {
-            fruit.ResetRandomFruit(BallHeight, gameTime, FruitType::MAIN); 
-        }
-    }
+    renderAlpha = simAccumulator / SIM_STEP;
+    syncCamera(renderAlpha);
 
-    for (auto& fruit : blackFruits) {
-        if (!fruit.IsActive()) {
-            fruit.ResetRandomFruit(BallHeight, gameTime, FruitType::BLACK); 
-        }
+    if (world.IsOver()) {
+        currentState = GAMEOVER;
+        finishRecording();
     }
 
     glutPostRedisplay();
@@ -393,35 +444,44 @@ void drawMenu() {
 
     // Title and instruction text
     const int charWidth = 15;
-    string titleText    = "Select Difficulty";
-    string instructText1= "Use WASD to move, Mouse to look around";
-    string instructText2= "Press Q to quit game";
-    string instructText3= "Press Z to end game and show score";
-
-    int titleWidth   = titleText.size()    * charWidth;
-    int instruct1Width = instructText1.size() * charWidth;
-    int instruct2Width = instructText2.size() * charWidth;
-    int instruct3Width = instructText3.size() * charWidth;
-
-    glDisable(GL_LIGHTING);
-    glColor3f(0.9f, 0.9f, 0.9f);  // Title color
-    scoreText.RenderText(WINDOW_WIDTH/2 - titleWidth/2 + 55, WINDOW_HEIGHT/3 - 10, titleText);
+    const char* titleText     = "Select Difficulty";
+    const char* instructText1 = "Use WASD to move, Mouse to look around";
+    const char* instructText2 = "Press Q to quit game";
+    const char* instructText3 = "Press Z to end game and show score";
+
+    int titleWidth     = strlen(titleText)     * charWidth;
+    int instruct1Width = strlen(instructText1) * charWidth;
+    int instruct2Width = strlen(instructText2) * charWidth;
+    int instruct3Width = strlen(instructText3) * charWidth;
+
+    // Title in light gray
+    scoreText.Queue(WINDOW_WIDTH/2 - titleWidth/2 + 55, WINDOW_HEIGHT/3 - 10, titleText, 0.9f, 0.9f, 0.9f);
     for (const auto& btn : difficultyButtons) {
-        drawButton(btn);
+        submitButton(btn);
     }
 
-    // Draw instruction text (yellow)
-    glColor3f(1.0f, 1.0f, 0.0f);
-    scoreText.RenderText(WINDOW_WIDTH/2 - instruct1Width/2 + 90, WINDOW_HEIGHT - 130, instructText1);
-    scoreText.RenderText(WINDOW_WIDTH/2 - instruct2Width/2 + 60, WINDOW_HEIGHT - 100, instructText2);
-    scoreText.RenderText(WINDOW_WIDTH/2 - instruct3Width/2 + 90, WINDOW_HEIGHT - 70,  instructText3);
+    // Instruction text in yellow
+    scoreText.Queue(WINDOW_WIDTH/2 - instruct1Width/2 + 90, WINDOW_HEIGHT - 130, instructText1, 1.0f, 1.0f, 0.0f);
+    scoreText.Queue(WINDOW_WIDTH/2 - instruct2Width/2 + 60, WINDOW_HEIGHT - 100, instructText2, 1.0f, 1.0f, 0.0f);
+    scoreText.Queue(WINDOW_WIDTH/2 - instruct3Width/2 + 90, WINDOW_HEIGHT - 70,  instructText3, 1.0f, 1.0f, 0.0f);
+    scoreText.Submit(renderQueue);
+    renderQueue.Execute();
 
     glutSwapBuffers();
 }
 
-void drawButton(const Button& btn) {
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DEPTH_TEST);
+void submitButton(const Button& btn) {
+    RenderState state = { 0, 0, false, false, false };
+    renderQueue.Submit(PASS_OVERLAY, state, PHASE_HUD, drawButton, const_cast<Button*>(&btn));
+
+    // Button text, drawn with the rest of the menu text
+    float textX = btn.x + (btn.width - btn.text.length() * 9) / 2.0f;
+    float textY = btn.y + (btn.height + 10) / 2.0f;
+    scoreText.Queue(textX, textY, btn.text.c_str(), 1.0f, 1.0f, 1.0f);
+}
+
+int drawButton(void* context) {
+    const Button& btn = *static_cast<const Button*>(context);
 
     if (btn.isHovered) {
         glColor4f(0.4f, 0.7f, 1.0f, 1.0f);  // Light blue when hovered
@@ -446,62 +506,38 @@ void drawButton(const Button& btn) {
         glVertex2f(btn.x,            btn.y+btn.height);
     glEnd();
 
-    // Button text
-    glColor3f(1.0f, 1.0f, 1.0f);
-    float textX = btn.x + (btn.width - btn.text.length() * 9) / 2.0f;
-    float textY = btn.y + (btn.height + 10) / 2.0f;
-    scoreText.RenderText(textX, textY, btn.text);
+    return 2;
+}
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
+// --balls N stress runs: the same 7:5 split of main and black balls as
+// MEDIUM's starting counts
+void splitBallCount(int total, int& mainCount, int& blackCount) {
+    mainCount  = total * 7 / 12;
+    blackCount = total - mainCount;
 }
 
 void startGame(Difficulty diff) {
-    currentState       = PLAYING;
-    selectedDifficulty = diff;
-    score             = 0;
-    gameTime          = 0.0f;
-    gameOverStartTime = 0.0f;
-
-    mainFruits.clear();
-    blackFruits.clear();
-
-    switch (diff) {
-        case EASY:
-            life = 5;
-            fruitSpeedMultiplier = 1.0f;
-            for (int i = 0; i < 5; ++i) {
-                mainFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::MAIN);
-            }
-            for (int i = 0; i < 3; ++i) {
-                blackFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::BLACK);
-            }
-            break;
-        case MEDIUM:
-            life = 3;
-            fruitSpeedMultiplier = 1.5f;
-            for (int i = 0; i < 7; ++i) {
-                mainFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::MAIN);
-            }
-            for (int i = 0; i < 5; ++i) {
-                blackFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::BLACK);
-            }
-            break;
-        case HARD:
-            life = 1;
-            fruitSpeedMultiplier = 2.0f;
-            for (int i = 0; i < 10; ++i) {
-                mainFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::MAIN);
-            }
-            for (int i = 0; i < 7; ++i) {
-                blackFruits.emplace_back(Vector3(0, BallHeight + 5*i, 0), FruitType::BLACK);
-            }
-            break;
+    // The arena needs its textures before the first frame
+    assets.Wait();
+
+    currentState = PLAYING;
+    world.SetSeed(static_cast<uint32_t>(time(nullptr)));
+    if (ballCountOverride > 0) {
+        int mainCount, blackCount;
+        splitBallCount(ballCountOverride, mainCount, blackCount);
+        world.Start(diff, mainCount, blackCount);
+    }
+    else {
+        world.Start(diff);
     }
+    resetInterpolation();
+    Profiler::Get().DiscardFrame();
 
-    camera.PositionCamera(0.0f, 2.0f, 6.0f,
-                         0.0f, 0.0f, 0.0f,
-                         0.0f, 1.0f, 0.0f);
+    pendingSpeed   = 0.0f;
+    pendingEndGame = false;
+    if (recordPath) {
+        recorder.Begin(world, diff, REPLAY_KEYFRAME_INTERVAL);
+    }
 
     glutSetCursor(GLUT_CURSOR_NONE);
     glutWarpPointer(WINDOW_WIDTH/2, WINDOW_HEIGHT/2);
@@ -550,22 +586,8 @@ void mouseMotion(int x, int y) {
     lastMouseX = x;
     lastMouseY = y;
 
-    xoffset *= mouseSensitivity;
-    yoffset *= mouseSensitivity;
-
-    yaw   += xoffset;
-    pitch += yoffset;
-
-    if (pitch > 89.0f)  pitch = 89.0f;
-    if (pitch < -89.0f) pitch = -89.0f;
-
-    Vector3 direction;
-    direction.x = cos(yaw * 0.0174532925f) * cos(pitch * 0.0174532925f);
-    direction.y = sin(pitch * 0.0174532925f);
-    direction.z = sin(yaw * 0.0174532925f) * cos(pitch * 0.0174532925f);
-    direction.Normalize();
-
-    camera.m_vView = camera.m_vPosition + direction;
+    pendingYaw   += xoffset * mouseSensitivity;
+    pendingPitch += yoffset * mouseSensitivity;
 
     if (x != WINDOW_WIDTH/2 || y != WINDOW_HEIGHT/2) {
         glutWarpPointer(WINDOW_WIDTH/2, WINDOW_HEIGHT/2);
@@ -587,23 +609,21 @@ void keyboard(unsigned char key, int x, int y) {
     }
 
     if (currentState == PLAYING) {
+        // Ends the game on the next step, so replays see it too
         if (key == 'z' || key == 'Z') {
-            currentState = GAMEOVER;
-            gameOverStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+            pendingEndGame = true;
             return;
         }
 
+        if (key == 'p' || key == 'P') {
+            showProfiler = !showProfiler;
+        }
+
         if (key == '+' || key == '=') {
-            cameraSpeed         += 0.1f;
-            fruitSpeedMultiplier+= 0.1f;
-            cout << "Camera Speed: " << cameraSpeed
-                 << ", Fruit Speed Multiplier: " << fruitSpeedMultiplier << endl;
+            pendingSpeed += 0.1f;
         }
         else if (key == '-' || key == '_') {
-            cameraSpeed          = max(0.1f, cameraSpeed - 0.1f);
-            fruitSpeedMultiplier = max(0.1f, fruitSpeedMultiplier - 0.1f);
-            cout << "Camera Speed: " << cameraSpeed
-                 << ", Fruit Speed Multiplier: " << fruitSpeedMultiplier << endl;
+            pendingSpeed -= 0.1f;
         }
         else if (key == '[') {
             mouseSensitivity += 0.01f;
@@ -621,280 +641,262 @@ void keyboardUp(unsigned char key, int x, int y) {
     keyStates[key] = false;
 }
 
-void processKeys() {
-    if (currentState != PLAYING) return;
-
-    float speed = cameraSpeed;
-    if (keyStates[' ']) {
-        speed *= 2.0f;
-    }
-
-    Vector3 forward = camera.m_vView - camera.m_vPosition;
-    forward.y = 0;
-    forward.Normalize();
-
-    Vector3 right = forward.Cross(camera.m_vUpVector);
-    right.Normalize();
-
-    Vector3 movement(0, 0, 0);
-    if (keyStates['w'] || keyStates['W']) {
-        movement = movement + (forward * speed);
-    }
-    if (keyStates['s'] || keyStates['S']) {
-        movement = movement - (forward * speed);
-    }
-    if (keyStates['a'] || keyStates['A']) {
-        movement = movement - (right * speed);
-    }
-    if (keyStates['d'] || keyStates['D']) {
-        movement = movement + (right * speed);
-    }
+// Collect the current key state and mouse look into one simulation input
+GameInput processKeys() {
+    GameInput input;
+    input.forward  = keyStates['w'] || keyStates['W'];
+    input.backward = keyStates['s'] || keyStates['S'];
+    input.left     = keyStates['a'] || keyStates['A'];
+    input.right    = keyStates['d'] || keyStates['D'];
+    input.sprint   = keyStates[' '];
+
+    input.yawDelta   = pendingYaw;
+    input.pitchDelta = pendingPitch;
+    input.speedDelta = pendingSpeed;
+    input.endGame    = pendingEndGame;
+    pendingYaw     = 0.0f;
+    pendingPitch   = 0.0f;
+    pendingSpeed   = 0.0f;
+    pendingEndGame = false;
+
+    return input;
+}
 
-    Vector3 newPosition = camera.m_vPosition + movement;
+// Copy the simulated player viewpoint into the render camera, alpha of the
+// way from the previous step's pose to the current one
+void syncCamera(float alpha) {
+    Vector3 pos  = prevPosition + (world.GetPosition() - prevPosition) * alpha;
+    Vector3 view = prevView + (world.GetView() - prevView) * alpha;
+    const Vector3& up = world.GetUpVector();
+    camera.PositionCamera(pos.x,  pos.y,  pos.z,
+                          view.x, view.y, view.z,
+                          up.x,   up.y,   up.z);
+}
 
-    const float WALL_BUFFER = 1.0f;
-    bool collision = false;
+// Start interpolating from the current pose with no pending time
+void resetInterpolation() {
+    simAccumulator = 0.0f;
+    renderAlpha    = 0.0f;
+    prevPosition   = world.GetPosition();
+    prevView       = world.GetView();
+    syncCamera(0.0f);
+}
 
-    if (newPosition.x >= WALL_DISTANCE - WALL_BUFFER || newPosition.x <= -WALL_DISTANCE + WALL_BUFFER) {
-        collision = true;
-    }
-    if (newPosition.z >= WALL_DISTANCE - WALL_BUFFER || newPosition.z <= -WALL_DISTANCE + WALL_BUFFER) {
-        collision = true;
-    }
+void createGroundAndWalls() {
+    arena.Submit(renderQueue, wallTexture, camera.GetFrustum());
+}
 
-    if (!collision) {
-        camera.m_vPosition = newPosition;
-        camera.m_vView     = camera.m_vView + movement;
-    }
+// List the balls inside the camera's view for the renderers and count them
+void cullBalls() {
+    FruitPool& mainFruits  = world.GetMainFruits();
+    FruitPool& blackFruits = world.GetBlackFruits();
+    mainFruits.Cull(camera.GetFrustum(), renderAlpha);
+    blackFruits.Cull(camera.GetFrustum(), renderAlpha);
+
+    ballsDrawn  = static_cast<int>(mainFruits.Visible().size() + blackFruits.Visible().size());
+    ballsCulled = mainFruits.CulledCount() + blackFruits.CulledCount();
+    Profiler::Get().Count(COUNTER_BALLS_DRAWN, ballsDrawn);
+    Profiler::Get().Count(COUNTER_BALLS_CULLED, ballsCulled);
 }
 
-void checkCollisions() {
-    Vector3 cameraPos = camera.m_vPosition;
-    
+// Catch ring two units in front of the camera
+int drawRing(void*) {
     Vector3 viewDir = camera.m_vView - camera.m_vPosition;
     viewDir.Normalize();
     Vector3 ringPos = camera.m_vPosition + (viewDir * 2.0f);
 
-    for (auto& fruit : mainFruits) {
-        if (fruit.IsActive()) {
-            Vector3 fruitPos = fruit.GetPosition();
-            
-            Vector3 toFruit = fruitPos - ringPos;
-            float distAlongView = toFruit.Dot(viewDir);
-            Vector3 projection = ringPos + viewDir * distAlongView;
-            Vector3 toAxis = fruitPos - projection;
-            float distToAxis = sqrt(toAxis.x * toAxis.x + toAxis.y * toAxis.y + toAxis.z * toAxis.z);
-            
-            static Vector3 lastFruitPos = fruitPos;
-            float lastDistAlongView = (lastFruitPos - ringPos).Dot(viewDir);
-            
-            if ((lastDistAlongView * distAlongView < 0) &&
-                (distToAxis <= RING_RADIUS) &&
-                (distToAxis >= RING_RADIUS * 0.8f)) {
-                
-                int points = fruit.GetPoints();
-                score += points;
-                if (points < 0) {
-                    life--;
-                    if (life <= 0) {
-                        currentState = GAMEOVER;
-                        gameOverStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-                    }
-                }
-                fruit.SetActive(false);
-                continue;
-            }
-            
-            lastFruitPos = fruitPos;
-            
-            float dx = fruitPos.x - cameraPos.x;
-            float dz = fruitPos.z - cameraPos.z;
-            float distToPlayer = sqrt(dx*dx + dz*dz);
-            if (distToPlayer < CATCH_DISTANCE && fruitPos.y < cameraPos.y + 2.0f) {
-                int points = fruit.GetPoints();
-                score += points;
-                if (points < 0) {
-                    life--;
-                    if (life <= 0) {
-                        currentState = GAMEOVER;
-                        gameOverStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-                    }
-                }
-                fruit.SetActive(false);
-            }
-        }
-    }
+    catchRing.Draw(ringPos, viewDir);
+    return 1;
+}
 
-    for (auto& fruit : blackFruits) {
-        if (fruit.IsActive()) {
-            Vector3 fruitPos = fruit.GetPosition();
-            
-            Vector3 toFruit = fruitPos - ringPos;
-            float distAlongView = toFruit.Dot(viewDir);
-            Vector3 projection = ringPos + viewDir * distAlongView;
-            Vector3 toAxis = fruitPos - projection;
-            float distToAxis = sqrt(toAxis.x * toAxis.x + toAxis.y * toAxis.y + toAxis.z * toAxis.z);
-            
-            static Vector3 lastFruitPos = fruitPos;
-            float lastDistAlongView = (lastFruitPos - ringPos).Dot(viewDir);
-            
-            if ((lastDistAlongView * distAlongView < 0) &&
-                (distToAxis <= RING_RADIUS) &&
-                (distToAxis >= RING_RADIUS * 0.8f)) {
-                
-                isExploding = true;
-                explosionTime = 0.0f;
-                
-                int points = fruit.GetPoints();
-                score += points;
-                if (points < 0) {
-                    life--;
-                    if (life <= 0) {
-                        currentState = GAMEOVER;
-                        gameOverStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-                    }
-                }
-                fruit.SetActive(false);
-                continue;
-            }
-            
-            lastFruitPos = fruitPos;
-            
-            float dx = fruitPos.x - cameraPos.x;
-            float dz = fruitPos.z - cameraPos.z;
-            float distToPlayer = sqrt(dx*dx + dz*dz);
-            if (distToPlayer < CATCH_DISTANCE && fruitPos.y < cameraPos.y + 2.0f) {
-                isExploding = true;
-                explosionTime = 0.0f;
-                
-                int points = fruit.GetPoints();
-                score += points;
-                if (points < 0) {
-                    life--;
-                    if (life <= 0) {
-                        currentState = GAMEOVER;
-                        gameOverStartTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-                    }
-                }
-                fruit.SetActive(false);
-            }
-        }
-    }
+// One gluSphere per ball when instancing is unavailable
+int drawFallbackBalls(void*) {
+    return world.GetMainFruits().Draw(renderAlpha) + world.GetBlackFruits().Draw(renderAlpha);
 }
 
-void createGroundAndWalls() {
-    glDisable(GL_TEXTURE_2D);
-    glColor3f(1.0f, 1.0f, 1.0f);
+// Black quad over the window, fading in as the explosion plays out
+int drawExplosion(void*) {
+    float alpha = 1.0f - (world.GetExplosionTime() / EXPLOSION_DURATION);
+    if (alpha < 0.0f) alpha = 0.0f;
+    glColor4f(0.0f, 0.0f, 0.0f, alpha);
+
+    float width  = static_cast<float>(renderQueue.GetWidth());
+    float height = static_cast<float>(renderQueue.GetHeight());
     glBegin(GL_QUADS);
-        glNormal3f(0.0f, 1.0f, 0.0f);
-        glTexCoord2f(0.0f, 0.0f); glVertex3f(-GROUND_SIZE, GROUND_Y, -GROUND_SIZE);
-        glTexCoord2f(1.0f, 0.0f); glVertex3f( GROUND_SIZE, GROUND_Y, -GROUND_SIZE);
-        glTexCoord2f(1.0f, 1.0f); glVertex3f( GROUND_SIZE, GROUND_Y,  GROUND_SIZE);
-        glTexCoord2f(0.0f, 1.0f); glVertex3f(-GROUND_SIZE, GROUND_Y,  GROUND_SIZE);
+        glVertex2f(0, 0);
+        glVertex2f(width, 0);
+        glVertex2f(width, height);
+        glVertex2f(0, height);
     glEnd();
+    return 1;
+}
 
-    glEnable(GL_TEXTURE_2D);
-    wallTexture.BindTexture();
-    glColor3f(1.0f, 1.0f, 1.0f);
+// Queue the rolling average and p99 of each phase, top right of the HUD
+void drawProfiler() {
+    PhaseStats stats[PHASE_COUNT + 1];
+    Profiler::Get().ComputeStats(PROFILER_WINDOW, stats);
+
+    const float x = WINDOW_WIDTH - 300;
+    scoreText.Queue(x,       30, "phase", 0.0f, 0.0f, 0.0f);
+    scoreText.Queue(x + 110, 30, "avg ms", 0.0f, 0.0f, 0.0f);
+    scoreText.Queue(x + 200, 30, "p99 ms", 0.0f, 0.0f, 0.0f);
+
+    for (int phase = 0; phase <= PHASE_COUNT; ++phase) {
+        const char* name = phase < PHASE_COUNT ? Profiler::PhaseName(static_cast<ProfilePhase>(phase)) : "frame";
+        snprintf(profilerCells[phase][0], sizeof(profilerCells[phase][0]), "%s", name);
+        snprintf(profilerCells[phase][1], sizeof(profilerCells[phase][1]), "%.3f", stats[phase].averageMs);
+        snprintf(profilerCells[phase][2], sizeof(profilerCells[phase][2]), "%.3f", stats[phase].p99Ms);
+
+        float y = 55 + phase * 22;
+        scoreText.Queue(x,       y, profilerCells[phase][0], 0.0f, 0.0f, 0.0f);
+        scoreText.Queue(x + 110, y, profilerCells[phase][1], 0.0f, 0.0f, 0.0f);
+        scoreText.Queue(x + 200, y, profilerCells[phase][2], 0.0f, 0.0f, 0.0f);
+    }
+
+    // Render queue counts from the last frame
+    const RenderStats& render = renderQueue.GetStats();
+    snprintf(profilerCounts, sizeof(profilerCounts), "%d draws, %d state changes",
+             render.drawCalls, render.stateChanges);
+    scoreText.Queue(x, 55 + (PHASE_COUNT + 1) * 22, profilerCounts, 0.0f, 0.0f, 0.0f);
+
+    // Balls inside and outside the view this frame
+    snprintf(profilerCulling, sizeof(profilerCulling), "%d balls drawn, %d culled",
+             ballsDrawn, ballsCulled);
+    scoreText.Queue(x, 55 + (PHASE_COUNT + 2) * 22, profilerCulling, 0.0f, 0.0f, 0.0f);
+}
 
-    glBegin(GL_QUADS);
-        glNormal3f(0.0f, 0.0f, 1.0f);
-        glTexCoord2f(0.0f, 0.0f); glVertex3f(-GROUND_SIZE, GROUND_Y, -WALL_DISTANCE);
-        glTexCoord2f(4.0f, 0.0f); glVertex3f( GROUND_SIZE, GROUND_Y, -WALL_DISTANCE);
-        glTexCoord2f(4.0f, 1.0f); glVertex3f( GROUND_SIZE, WALL_HEIGHT, -WALL_DISTANCE);
-        glTexCoord2f(0.0f, 1.0f); glVertex3f(-GROUND_SIZE, WALL_HEIGHT, -WALL_DISTANCE);
-    glEnd();
+// atexit handler: dump the recorded frames if --profile-csv was given
+void exportProfile() {
+    if (!profileCsvPath) return;
+    if (Profiler::Get().ExportCsv(profileCsvPath)) {
+        cout << "Wrote frame profile to " << profileCsvPath << endl;
+    }
+    else {
+        cerr << "Could not write frame profile to " << profileCsvPath << endl;
+    }
+}
 
-    glBegin(GL_QUADS);
-        glNormal3f(0.0f, 0.0f, -1.0f);
-        glTexCoord2f(0.0f, 0.0f); glVertex3f(-GROUND_SIZE, GROUND_Y, WALL_DISTANCE);
-        glTexCoord2f(4.0f, 0.0f); glVertex3f( GROUND_SIZE, GROUND_Y, WALL_DISTANCE);
-        glTexCoord2f(4.0f, 1.0f); glVertex3f( GROUND_SIZE, WALL_HEIGHT, WALL_DISTANCE);
-        glTexCoord2f(0.0f, 1.0f); glVertex3f(-GROUND_SIZE, WALL_HEIGHT, WALL_DISTANCE);
-    glEnd();
+// Read the frame just drawn back for --capture, timed as its own phase
+void captureFrame() {
+    if (!frameCapture.IsActive()) return;
+    ProfileScope scope(PHASE_CAPTURE);
+    frameCapture.Capture();
+}
 
-    glBegin(GL_QUADS);
-        glNormal3f(-1.0f, 0.0f, 0.0f);
-        glTexCoord2f(0.0f, 0.0f); glVertex3f(WALL_DISTANCE, GROUND_Y, -GROUND_SIZE);
-        glTexCoord2f(4.0f, 0.0f); glVertex3f(WALL_DISTANCE, GROUND_Y,  GROUND_SIZE);
-        glTexCoord2f(4.0f, 1.0f); glVertex3f(WALL_DISTANCE, WALL_HEIGHT,  GROUND_SIZE);
-        glTexCoord2f(0.0f, 1.0f); glVertex3f(WALL_DISTANCE, WALL_HEIGHT, -GROUND_SIZE);
-    glEnd();
+// atexit handler: write out the frames still being read back
+void finishCapture() {
+    frameCapture.Finish();
+}
 
-    glBegin(GL_QUADS);
-        glNormal3f(1.0f, 0.0f, 0.0f);
-        glTexCoord2f(0.0f, 0.0f); glVertex3f(-WALL_DISTANCE, GROUND_Y, -GROUND_SIZE);
-        glTexCoord2f(4.0f, 0.0f); glVertex3f(-WALL_DISTANCE, GROUND_Y,  GROUND_SIZE);
-        glTexCoord2f(4.0f, 1.0f); glVertex3f(-WALL_DISTANCE, WALL_HEIGHT,  GROUND_SIZE);
-        glTexCoord2f(0.0f, 1.0f); glVertex3f(-WALL_DISTANCE, WALL_HEIGHT, -GROUND_SIZE);
-    glEnd();
+// atexit handler: free the loader's GL objects while the context is alive
+void shutdownAssets() {
+    assets.Shutdown();
+}
 
-    wallTexture.UnbindTexture();
-    glDisable(GL_TEXTURE_2D);
+// Write the replay of the current game, if one is being recorded. Later
+// games overwrite the same file.
+void finishRecording() {
+    if (!recorder.IsRecording()) return;
+    if (recorder.Finish(world, recordPath)) {
+        cout << "Wrote replay to " << recordPath << endl;
+    }
+    else {
+        cerr << "Could not write replay to " << recordPath << endl;
+    }
 }
 
-void drawRing() {
-    glDisable(GL_LIGHTING);
-    
-    glPushMatrix();
-    
-    Vector3 viewDir = camera.m_vView - camera.m_vPosition;
-    viewDir.Normalize();
-    Vector3 ringPos = camera.m_vPosition + (viewDir * 2.0f);
-    
-    glTranslatef(ringPos.x, ringPos.y, ringPos.z);
-    
-    float angleY = atan2(viewDir.z, viewDir.x) * 180.0f / M_PI;
-    float angleX = atan2(viewDir.y, sqrt(viewDir.x * viewDir.x + viewDir.z * viewDir.z)) * 180.0f / M_PI;
-    
-    glRotatef(-angleY, 0, 1, 0);
-    glRotatef(angleX, 1, 0, 0);
-    
-    glLineWidth(5.0f);
-    
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    const float innerRadius = RING_RADIUS * 0.8f;
-    float alpha = 0.3f;
-    
-    glColor4f(1.0f, 1.0f, 0.0f, alpha);
-    
-    glBegin(GL_QUAD_STRIP);
-    for(int i = 0; i <= RING_SEGMENTS; i++) {
-        float theta = 2.0f * M_PI * float(i) / float(RING_SEGMENTS);
-        float x1 = innerRadius * cosf(theta);
-        float y1 = innerRadius * sinf(theta);
-        float x2 = RING_RADIUS * cosf(theta);
-        float y2 = RING_RADIUS * sinf(theta);
-        
-        glVertex3f(x1, y1, 0);
-        glVertex3f(x2, y2, 0);
+// Start the benchmark's round: fixed seed, and --balls or the HARD ramp
+void startBenchmarkRound() {
+    world.SetSeed(RENDER_BENCH_SEED);
+    if (ballCountOverride > 0) {
+        int mainCount, blackCount;
+        splitBallCount(ballCountOverride, mainCount, blackCount);
+        world.Start(HARD, mainCount, blackCount);
     }
-    glEnd();
-    
-    glColor4f(1.0f, 1.0f, 0.0f, alpha + 0.2f);
-    
-    glBegin(GL_LINE_LOOP);
-    for(int i = 0; i < RING_SEGMENTS; i++) {
-        float theta = 2.0f * M_PI * float(i) / float(RING_SEGMENTS);
-        float x = RING_RADIUS * cosf(theta);
-        float y = RING_RADIUS * sinf(theta);
-        glVertex3f(x, y, 0);
+    else {
+        world.Start(HARD);
     }
-    glEnd();
-    
-    glBegin(GL_LINE_LOOP);
-    for(int i = 0; i < RING_SEGMENTS; i++) {
-        float theta = 2.0f * M_PI * float(i) / float(RING_SEGMENTS);
-        float x = innerRadius * cosf(theta);
-        float y = innerRadius * sinf(theta);
-        glVertex3f(x, y, 0);
+}
+
+// --render-bench FRAMES: draw a scripted lap around the arena offscreen,
+// one simulation step per frame, and print frame-time percentiles. Every
+// frame ends in glFinish() so the time includes the driver's rendering,
+// not just command submission.
+int runRenderBenchmark() {
+    bool egl = offscreen.InitEgl();
+    if (!egl) {
+        // No EGL: render from a hidden window's context instead
+        int argc = 1;
+        char name[] = "BallCatcherGame";
+        char* argv[] = { name, nullptr };
+        initializeGLUT(argc, argv);
+        glutHideWindow();
+    }
+    if (!offscreen.InitFramebuffer(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return 1;
+    }
+
+    showHud = false;
+    init();
+    if (capturePath && !frameCapture.Start(capturePath, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return 1;
     }
-    glEnd();
-    
-    glLineWidth(1.0f);
-    glDisable(GL_BLEND);
-    glPopMatrix();
-    glEnable(GL_LIGHTING);
+    assets.Wait();
+    reshape(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    currentState = PLAYING;
+    startBenchmarkRound();
+    renderAlpha = 0.5f;
+
+    const int total = RENDER_BENCH_WARMUP + renderBenchFrames;
+    vector<float> frameMs;
+    frameMs.reserve(renderBenchFrames);
+    GameInput idle;
+
+    for (int frame = 0; frame < total; ++frame) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        world.Step(SIM_STEP, idle);
+        if (world.IsOver()) {
+            startBenchmarkRound();
+        }
+
+        // Circle the arena at half its size, looking across it and tilting
+        // up into the falling balls and back down twice a lap
+        float angle = 2.0f * static_cast<float>(M_PI) * frame / RENDER_BENCH_ORBIT;
+        float radius = GROUND_SIZE * 0.5f;
+        Vector3 eye(cosf(angle) * radius, 2.0f, sinf(angle) * radius);
+        Vector3 target(-sinf(angle) * radius * 0.5f, 2.0f + 20.0f * sinf(2.0f * angle), cosf(angle) * radius * 0.5f);
+        camera.PositionCamera(eye.x,    eye.y,    eye.z,
+                              target.x, target.y, target.z,
+                              0.0f,     1.0f,     0.0f);
+
+        renderScene();
+        captureFrame();
+        glFinish();
+
+        if (frame < RENDER_BENCH_WARMUP) {
+            Profiler::Get().DiscardFrame();
+            continue;
+        }
+        Profiler::Get().EndFrame();
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        frameMs.push_back(elapsed.count());
+    }
+
+    vector<float> sorted = frameMs;
+    sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (float ms : frameMs) sum += ms;
+    float mean = static_cast<float>(sum / frameMs.size());
+
+    int balls = world.GetMainFruits().LiveCount() + world.GetBlackFruits().LiveCount();
+    printf("Rendered %d frames at %dx%d, %d balls, %s, %s\n",
+           renderBenchFrames, WINDOW_WIDTH, WINDOW_HEIGHT, balls,
+           egl ? "EGL" : "hidden GLUT window",
+           reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    printf("frame ms: mean %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f  (%.1f fps)\n",
+           mean, Percentile(sorted, 0.50f), Percentile(sorted, 0.90f),
+           Percentile(sorted, 0.99f), sorted.back(), 1000.0f / mean);
+    return 0;
 }
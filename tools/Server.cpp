@@ -0,0 +1,458 @@
+// Authoritative headless game server: hosts many independent sessions,
+// one GameWorld each, stepped together at a fixed tick rate. Clients send
+// their input over UDP and get back a quantized snapshot every tick,
+// delta-encoded against the newest one they acknowledged (NetProtocol.h).
+// Rounds restart when they end, so a session runs until its client
+// disconnects or goes quiet.
+//
+//   ballquest_server [--port P] [--tick-rate HZ] [--threads N]
+//                    [--max-sessions N] [--seed S] [--seconds S] [--report S]
+//
+// The tick rate is rounded to a whole number of SIM_STEP steps per tick
+// (120 Hz / k). Every --report seconds it prints the load, including how
+// many sessions one core sustains at that rate.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../include/GameWorld.h"
+#include "../include/JobSystem.h"
+#include "../include/NetProtocol.h"
+#include "../include/Replay.h"
+#include "../include/Serialize.h"
+#include "../include/UdpSocket.h"
+
+using namespace std;
+
+const double SESSION_TIMEOUT = 5.0;     // Seconds without a datagram before a session is dropped
+
+struct Session {
+    bool        live;
+    uint16_t    id;
+    uint32_t    nonce;
+    sockaddr_in address;
+    Difficulty  difficulty;
+    uint32_t    seed;
+    uint16_t    round;
+    uint32_t    tick;                   // Snapshots sent so far
+    double      lastHeard;
+
+    // Input received since the last tick
+    uint32_t    lastInput;              // Newest input sequence taken, 0 before any
+    uint8_t     keys;
+    float       yawDelta;
+    float       pitchDelta;
+    uint32_t    ackTick;
+
+    GameWorld   world;
+    NetSnapshot history[NET_SNAPSHOT_HISTORY];
+    uint32_t    historyTick[NET_SNAPSHOT_HISTORY];
+    vector<uint8_t> packet;             // This tick's snapshot datagram
+};
+
+static volatile sig_atomic_t s_quit = 0;
+
+static void OnSignal(int) {
+    s_quit = 1;
+}
+
+static double CpuSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1.0e-9;
+}
+
+static bool SameAddress(const sockaddr_in& a, const sockaddr_in& b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+static void StartRound(Session& session) {
+    session.world.SetSeed(session.seed + session.round);
+    session.world.Start(session.difficulty);
+    ++session.round;
+}
+
+class Server {
+public:
+    Server(int maxSessions, float tickRate, int threadCount, uint32_t seed)
+        : m_tickRate(tickRate), m_seed(seed), m_created(0), m_jobs(threadCount) {
+        m_sessions.resize(maxSessions);
+        memset(&m_stats, 0, sizeof(m_stats));
+        m_stats.threads = m_jobs.ThreadCount();
+        m_stats.tickRate = tickRate;
+        m_cpuStart = CpuSeconds();
+        m_wallStart = chrono::steady_clock::now();
+    }
+
+    bool Open(uint16_t port) { return m_socket.Open(port, 8 << 20); }
+
+    void Run(double seconds, double reportEvery);
+
+private:
+    void Receive(double now);
+    void HandleConnect(StateReader& in, const sockaddr_in& from, double now);
+    void HandleInput(StateReader& in, const sockaddr_in& from, double now);
+    void HandleDisconnect(StateReader& in, const sockaddr_in& from);
+    void SendStats(const sockaddr_in& from);
+    void Tick(double now);
+    void Report(const NetServerStats& since, double interval);
+    Session* Find(uint16_t id, const sockaddr_in& from);
+    int  LiveCount() const;
+    void UpdateClock();
+
+    float    m_tickRate;
+    uint32_t m_seed;
+    uint32_t m_created;                 // Sessions ever opened, for their seeds
+    JobSystem m_jobs;
+    UdpSocket m_socket;
+    vector<unique_ptr<Session>> m_sessions;   // Index is the session id
+    vector<Session*> m_live;            // Scratch for each tick
+    NetServerStats m_stats;
+    double m_cpuStart;
+    chrono::steady_clock::time_point m_wallStart;
+    vector<uint8_t> m_datagram;
+    vector<uint8_t> m_reply;
+    double m_tickSeconds;               // Tick work since the last report
+    double m_tickMax;
+};
+
+Session* Server::Find(uint16_t id, const sockaddr_in& from) {
+    if (id >= m_sessions.size() || !m_sessions[id] || !m_sessions[id]->live) return nullptr;
+    Session* session = m_sessions[id].get();
+    return SameAddress(session->address, from) ? session : nullptr;
+}
+
+int Server::LiveCount() const {
+    int count = 0;
+    for (const unique_ptr<Session>& session : m_sessions) {
+        if (session && session->live) ++count;
+    }
+    return count;
+}
+
+void Server::UpdateClock() {
+    m_stats.cpuSeconds  = CpuSeconds() - m_cpuStart;
+    m_stats.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - m_wallStart).count();
+}
+
+void Server::Receive(double now) {
+    m_datagram.resize(NET_MAX_DATAGRAM);
+    sockaddr_in from;
+    int size;
+    while ((size = m_socket.Receive(m_datagram.data(), m_datagram.size(), &from)) >= 0) {
+        m_stats.bytesReceived += size;
+        StateReader in(m_datagram.data(), size);
+        uint8_t type = 0;
+        if (!in.Read(type)) continue;
+        switch (type) {
+        case NET_CONNECT:       HandleConnect(in, from, now); break;
+        case NET_INPUT:         HandleInput(in, from, now); break;
+        case NET_DISCONNECT:    HandleDisconnect(in, from); break;
+        case NET_STATS_REQUEST: SendStats(from); break;
+        default: break;
+        }
+    }
+}
+
+void Server::HandleConnect(StateReader& in, const sockaddr_in& from, double now) {
+    NetConnect connect;
+    if (!in.Read(connect) || connect.version != NET_PROTOCOL_VERSION || connect.difficulty > HARD) return;
+
+    // A retry of a CONNECT whose ACCEPT was lost gets the same session
+    int id = -1;
+    for (size_t i = 0; i < m_sessions.size() && id < 0; ++i) {
+        const Session* session = m_sessions[i].get();
+        if (session && session->live && session->nonce == connect.nonce && SameAddress(session->address, from)) {
+            id = static_cast<int>(i);
+        }
+    }
+    for (size_t i = 0; i < m_sessions.size() && id < 0; ++i) {
+        if (m_sessions[i] && m_sessions[i]->live) continue;
+        if (!m_sessions[i]) {
+            m_sessions[i].reset(new Session());
+            SpawnSchedule hard = DefaultSpawnSchedule(HARD);
+            m_sessions[i]->world.ReserveFruits(hard.mainPeak, hard.blackPeak);
+        }
+        Session& session = *m_sessions[i];
+        session.live       = true;
+        session.id         = static_cast<uint16_t>(i);
+        session.nonce      = connect.nonce;
+        session.address    = from;
+        session.difficulty = static_cast<Difficulty>(connect.difficulty);
+        session.seed       = m_seed + 7919u * m_created++;
+        session.round      = 0;
+        session.tick       = 0;
+        session.lastHeard  = now;
+        session.lastInput  = 0;
+        session.keys       = 0;
+        session.yawDelta   = 0.0f;
+        session.pitchDelta = 0.0f;
+        session.ackTick    = NET_NO_TICK;
+        for (uint32_t& tick : session.historyTick) tick = NET_NO_TICK;
+        StartRound(session);
+        id = static_cast<int>(i);
+    }
+
+    NetAccept accept = {};
+    accept.nonce    = connect.nonce;
+    accept.tickRate = m_tickRate;
+    accept.session  = id < 0 ? NET_NO_SESSION : static_cast<uint16_t>(id);
+    m_reply.assign(1, static_cast<uint8_t>(NET_ACCEPT));
+    StateWriter out(m_reply);
+    out.Write(accept);
+    if (m_socket.Send(from, m_reply.data(), m_reply.size())) m_stats.bytesSent += m_reply.size();
+}
+
+void Server::HandleInput(StateReader& in, const sockaddr_in& from, double now) {
+    NetInputHeader header;
+    if (!in.Read(header)) return;
+    Session* session = Find(header.session, from);
+    if (!session) return;
+    session->lastHeard = now;
+
+    // Acks can arrive out of order; only a newer one moves the base on
+    if (header.ackTick != NET_NO_TICK && header.ackTick < session->tick &&
+        (session->ackTick == NET_NO_TICK || header.ackTick > session->ackTick)) {
+        session->ackTick = header.ackTick;
+    }
+
+    // Newest first; take every input not seen yet, so redundant copies
+    // fill in for lost datagrams
+    uint32_t newest = session->lastInput;
+    for (int k = 0; k < header.count; ++k) {
+        NetInput input;
+        if (!in.Read(input)) break;
+        if (input.sequence <= session->lastInput) continue;
+        if (input.sequence > newest) {
+            newest = input.sequence;
+            session->keys = input.keys;
+        }
+        session->yawDelta   += input.yawDelta * 0.01f;
+        session->pitchDelta += input.pitchDelta * 0.01f;
+    }
+    session->lastInput = newest;
+}
+
+void Server::HandleDisconnect(StateReader& in, const sockaddr_in& from) {
+    uint16_t id;
+    if (!in.Read(id)) return;
+    Session* session = Find(id, from);
+    if (session) session->live = false;
+}
+
+void Server::SendStats(const sockaddr_in& from) {
+    UpdateClock();
+    m_reply.assign(1, static_cast<uint8_t>(NET_STATS));
+    StateWriter out(m_reply);
+    out.Write(m_stats);
+    if (m_socket.Send(from, m_reply.data(), m_reply.size())) m_stats.bytesSent += m_reply.size();
+}
+
+void Server::Tick(double now) {
+    m_live.clear();
+    for (unique_ptr<Session>& session : m_sessions) {
+        if (!session || !session->live) continue;
+        if (now - session->lastHeard > SESSION_TIMEOUT) {
+            session->live = false;
+            continue;
+        }
+        m_live.push_back(session.get());
+    }
+
+    // Sessions share nothing, so they step and encode in parallel; the
+    // sends stay on this thread
+    const int steps = max(1, static_cast<int>(lround(1.0 / (m_tickRate * SIM_STEP))));
+    auto body = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            Session& session = *m_live[i];
+            GameInput input;
+            input.forward    = (session.keys & REPLAY_KEY_FORWARD) != 0;
+            input.backward   = (session.keys & REPLAY_KEY_BACKWARD) != 0;
+            input.left       = (session.keys & REPLAY_KEY_LEFT) != 0;
+            input.right      = (session.keys & REPLAY_KEY_RIGHT) != 0;
+            input.sprint     = (session.keys & REPLAY_KEY_SPRINT) != 0;
+            input.endGame    = (session.keys & REPLAY_KEY_END_GAME) != 0;
+            input.yawDelta   = session.yawDelta;
+            input.pitchDelta = session.pitchDelta;
+            session.yawDelta = session.pitchDelta = 0.0f;
+
+            for (int s = 0; s < steps; ++s) {
+                session.world.Step(SIM_STEP, input);
+                input.yawDelta = input.pitchDelta = 0.0f;
+                input.endGame = false;
+            }
+            if (session.world.IsOver()) {
+                StartRound(session);
+            }
+
+            uint32_t tick = session.tick++;
+            int slot = tick % NET_SNAPSHOT_HISTORY;
+            NetSnapshot& state = session.history[slot];
+            CaptureSnapshot(session.world, session.round, state);
+            session.historyTick[slot] = tick;
+
+            // The acknowledged snapshot is the base while it is still kept
+            const NetSnapshot* base = nullptr;
+            uint32_t baseTick = NET_NO_TICK;
+            uint32_t ack = session.ackTick;
+            if (ack != NET_NO_TICK && tick - ack < NET_SNAPSHOT_HISTORY &&
+                session.historyTick[ack % NET_SNAPSHOT_HISTORY] == ack) {
+                base = &session.history[ack % NET_SNAPSHOT_HISTORY];
+                baseTick = ack;
+            }
+
+            NetSnapshotHeader header = {};
+            header.tick     = tick;
+            header.baseTick = baseTick;
+            header.hash     = HashSnapshot(state);
+            header.session  = session.id;
+            session.packet.clear();
+            StateWriter out(session.packet);
+            out.Write(static_cast<uint8_t>(NET_SNAPSHOT));
+            out.Write(header);
+            EncodeSnapshot(state, base, session.packet);
+        }
+    };
+    m_jobs.ParallelFor(static_cast<int>(m_live.size()), 4, body);
+
+    for (Session* session : m_live) {
+        if (session->packet.size() <= NET_MAX_DATAGRAM &&
+            m_socket.Send(session->address, session->packet.data(), session->packet.size())) {
+            m_stats.bytesSent += session->packet.size();
+        }
+    }
+    ++m_stats.ticks;
+    m_stats.sessionTicks += m_live.size();
+}
+
+void Server::Report(const NetServerStats& since, double interval) {
+    UpdateClock();
+    double ticks = double(m_stats.ticks - since.ticks);
+    double sessions = ticks > 0 ? (m_stats.sessionTicks - since.sessionTicks) / ticks : 0.0;
+    double cores = (m_stats.cpuSeconds - since.cpuSeconds) / interval;
+    double perSession = sessions > 0 ? (m_stats.bytesSent - since.bytesSent) / interval / sessions : 0.0;
+    printf("%7.1f s  %5.0f sessions  tick %6.3f ms mean %6.3f max  %4llu overruns  "
+           "%5.2f cores  %6.0f sessions/core  %6.2f KB/s out per session\n",
+           m_stats.wallSeconds, sessions,
+           ticks > 0 ? 1000.0 * m_tickSeconds / ticks : 0.0, 1000.0 * m_tickMax,
+           (unsigned long long)(m_stats.overruns - since.overruns),
+           cores, cores > 0 ? sessions / cores : 0.0, perSession / 1024.0);
+    fflush(stdout);
+}
+
+void Server::Run(double seconds, double reportEvery) {
+    typedef chrono::steady_clock Clock;
+    const Clock::duration interval = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / m_tickRate));
+    Clock::time_point next = Clock::now();
+    Clock::time_point reportAt = next + chrono::duration_cast<Clock::duration>(chrono::duration<double>(reportEvery));
+    NetServerStats since = m_stats;
+    m_tickSeconds = 0.0;
+    m_tickMax = 0.0;
+
+    while (!s_quit) {
+        Clock::time_point tickStart = Clock::now();
+        double now = chrono::duration<double>(tickStart - m_wallStart).count();
+        if (seconds > 0.0 && now >= seconds) break;
+
+        Receive(now);
+        Tick(now);
+
+        double work = chrono::duration<double>(Clock::now() - tickStart).count();
+        m_tickSeconds += work;
+        m_tickMax = max(m_tickMax, work);
+
+        if (reportEvery > 0.0 && Clock::now() >= reportAt) {
+            Report(since, reportEvery);
+            since = m_stats;
+            m_tickSeconds = 0.0;
+            m_tickMax = 0.0;
+            reportAt += chrono::duration_cast<Clock::duration>(chrono::duration<double>(reportEvery));
+        }
+
+        // Answer datagrams while waiting for the next tick. A tick that
+        // ran late starts the schedule over rather than bunching up.
+        next += interval;
+        Clock::time_point wakeUp = Clock::now();
+        if (wakeUp > next) {
+            ++m_stats.overruns;
+            next = wakeUp;
+            continue;
+        }
+        while (!s_quit && (wakeUp = Clock::now()) < next) {
+            int waitMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(next - wakeUp).count());
+            if (waitMs <= 0) {
+                this_thread::sleep_until(next);
+                break;
+            }
+            if (m_socket.Wait(waitMs)) {
+                Receive(chrono::duration<double>(Clock::now() - m_wallStart).count());
+            }
+        }
+    }
+
+    UpdateClock();
+    double cores = m_stats.wallSeconds > 0 ? m_stats.cpuSeconds / m_stats.wallSeconds : 0.0;
+    double sessions = m_stats.ticks > 0 ? double(m_stats.sessionTicks) / m_stats.ticks : 0.0;
+    printf("%llu ticks in %.1f s, %.1f sessions on average, %.2f cores, %llu overruns, "
+           "%.1f MB out, %.1f MB in, %d sessions still open\n",
+           (unsigned long long)m_stats.ticks, m_stats.wallSeconds, sessions, cores,
+           (unsigned long long)m_stats.overruns,
+           m_stats.bytesSent / 1.0e6, m_stats.bytesReceived / 1.0e6, LiveCount());
+}
+
+int main(int argc, char** argv) {
+    int port = NET_DEFAULT_PORT;
+    float tickRate = 60.0f;
+    int threadCount = 0;
+    int maxSessions = 1024;
+    uint32_t seed = 1;
+    double seconds = 0.0;
+    double reportEvery = 5.0;
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--port") == 0) {
+            port = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--tick-rate") == 0) {
+            tickRate = static_cast<float>(atof(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--max-sessions") == 0) {
+            maxSessions = max(1, min(static_cast<int>(NET_NO_SESSION), atoi(argv[i + 1])));
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = atof(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--report") == 0) {
+            reportEvery = atof(argv[i + 1]);
+        }
+    }
+
+    // Whole steps per tick
+    int steps = max(1, static_cast<int>(lround(1.0 / (max(1.0f, tickRate) * SIM_STEP))));
+    tickRate = 1.0f / (steps * SIM_STEP);
+
+    Server server(maxSessions, tickRate, threadCount, seed);
+    if (!server.Open(static_cast<uint16_t>(port))) {
+        fprintf(stderr, "Could not open UDP port %d\n", port);
+        return 1;
+    }
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    printf("Serving up to %d sessions on UDP port %d at %.0f Hz (%d steps per tick)\n",
+           maxSessions, port, tickRate, steps);
+    fflush(stdout);
+    server.Run(seconds, reportEvery);
+    return 0;
+}
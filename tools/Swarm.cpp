@@ -0,0 +1,415 @@
+// Synthetic client swarm for ballquest_server: opens many sessions from
+// one process, each on its own UDP socket, plays them with a simple
+// chaser bot driven only by the snapshots it decodes, and reports the
+// traffic per client and the server's load over the run.
+//
+//   ballquest_swarm [--server HOST[:PORT]] [--clients N] [--seconds S]
+//                   [--difficulty easy|medium|hard] [--loss PERCENT]
+//
+// --loss drops that share of datagrams each way on the client side, to
+// exercise the redundant inputs and deltas against older acknowledged
+// snapshots. Every decoded snapshot is checked against the hash the
+// server sent with it.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../include/NetProtocol.h"
+#include "../include/Profiler.h"
+#include "../include/Random.h"
+#include "../include/Replay.h"
+#include "../include/Serialize.h"
+#include "../include/UdpSocket.h"
+
+using namespace std;
+
+const float  MAX_TURN        = 12.0f;   // Degrees per tick
+const float  CATCH_HEIGHT    = 4.0f;
+const float  ARRIVE_RADIUS   = 0.3f;
+const double CONNECT_TIMEOUT = 5.0;     // Seconds to wait for every ACCEPT
+const double WARM_UP         = 1.0;     // Seconds played before measuring
+
+static const char* const DIFFICULTY_NAMES[3] = { "easy", "medium", "hard" };
+
+struct Traffic {
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t datagramsSent;
+    uint64_t datagramsReceived;
+    uint64_t snapshots;           // Decoded
+    uint64_t fullSnapshots;       // Sent without a base
+    uint64_t fullBytes;
+    uint64_t deltaBytes;
+    uint64_t badHashes;
+    uint64_t missingBase;         // Base no longer held; snapshot dropped
+    uint64_t outOfOrder;          // Older than one already decoded
+};
+
+struct Client {
+    UdpSocket socket;
+    uint32_t  nonce;
+    uint16_t  session;
+    bool      accepted;
+    uint32_t  newest;             // Newest tick decoded, or NET_NO_TICK
+    NetSnapshot states[NET_SNAPSHOT_HISTORY];
+    uint32_t    stateTick[NET_SNAPSHOT_HISTORY];
+    NetInput    inputs[NET_INPUT_REDUNDANCY];   // Newest first
+    uint32_t    sequence;
+    Traffic     traffic;
+};
+
+// Loopback drops nothing by itself
+static bool Dropped(Random& random, float loss) {
+    return loss > 0.0f && Random::Below(random.Next(), 10000) < static_cast<uint32_t>(loss * 100.0f);
+}
+
+static void Send(Client& client, const sockaddr_in& server, const vector<uint8_t>& datagram,
+                 Random& random, float loss) {
+    client.traffic.bytesSent += datagram.size();
+    ++client.traffic.datagramsSent;
+    if (Dropped(random, loss)) return;
+    client.socket.Send(server, datagram.data(), datagram.size());
+}
+
+static void SendConnect(Client& client, const sockaddr_in& server, Difficulty difficulty) {
+    NetConnect connect = {};
+    connect.version    = NET_PROTOCOL_VERSION;
+    connect.nonce      = client.nonce;
+    connect.difficulty = difficulty;
+    vector<uint8_t> datagram;
+    StateWriter out(datagram);
+    out.Write(static_cast<uint8_t>(NET_CONNECT));
+    out.Write(connect);
+    client.socket.Send(server, datagram.data(), datagram.size());
+}
+
+static void HandleSnapshot(Client& client, StateReader& in, const uint8_t* payload, size_t size) {
+    NetSnapshotHeader header;
+    if (!in.Read(header) || header.session != client.session) return;
+    Traffic& traffic = client.traffic;
+    if (client.newest != NET_NO_TICK && header.tick <= client.newest) {
+        ++traffic.outOfOrder;
+        return;
+    }
+
+    const NetSnapshot* base = nullptr;
+    if (header.baseTick != NET_NO_TICK) {
+        int baseSlot = header.baseTick % NET_SNAPSHOT_HISTORY;
+        if (client.stateTick[baseSlot] != header.baseTick) {
+            ++traffic.missingBase;
+            return;
+        }
+        base = &client.states[baseSlot];
+    }
+
+    // The server only deltas against the last NET_SNAPSHOT_HISTORY ticks,
+    // so the new slot never holds the base
+    int slot = header.tick % NET_SNAPSHOT_HISTORY;
+    client.stateTick[slot] = NET_NO_TICK;
+    if (!DecodeSnapshot(payload, size, base, client.states[slot])) return;
+    if (HashSnapshot(client.states[slot]) != header.hash) {
+        ++traffic.badHashes;
+        return;
+    }
+    client.stateTick[slot] = header.tick;
+    client.newest = header.tick;
+
+    ++traffic.snapshots;
+    if (base) {
+        traffic.deltaBytes += size;
+    }
+    else {
+        ++traffic.fullSnapshots;
+        traffic.fullBytes += size;
+    }
+}
+
+static void Drain(Client& client, vector<uint8_t>& buffer, Random& random, float loss) {
+    buffer.resize(NET_MAX_DATAGRAM);
+    sockaddr_in from;
+    int size;
+    while ((size = client.socket.Receive(buffer.data(), buffer.size(), &from)) >= 0) {
+        if (Dropped(random, loss)) continue;
+        client.traffic.bytesReceived += size;
+        ++client.traffic.datagramsReceived;
+
+        StateReader in(buffer.data(), size);
+        uint8_t type = 0;
+        in.Read(type);
+        if (type == NET_ACCEPT) {
+            NetAccept accept;
+            if (in.Read(accept) && accept.nonce == client.nonce && accept.session != NET_NO_SESSION) {
+                client.session = accept.session;
+                client.accepted = true;
+            }
+        }
+        else if (type == NET_SNAPSHOT && client.accepted) {
+            size_t header = 1 + sizeof(NetSnapshotHeader);
+            if (static_cast<size_t>(size) >= header) {
+                HandleSnapshot(client, in, buffer.data() + header, size - header);
+            }
+        }
+    }
+}
+
+// Chase the nearest regular ball still above catch height, using only
+// what the newest snapshot says
+static NetInput BotInput(const Client& client) {
+    NetInput input = {};
+    if (client.newest == NET_NO_TICK) return input;
+    const NetSnapshot& state = client.states[client.newest % NET_SNAPSHOT_HISTORY];
+    const NetPlayer& player = state.player;
+    float px = player.x / 64.0f;
+    float pz = player.z / 64.0f;
+
+    float bestDistSq = 1.0e9f;
+    float tx = 0.0f, tz = 0.0f;
+    for (const NetBall& ball : state.balls) {
+        if ((ball.flags & NET_BALL_ACTIVE) == 0 || (ball.flags & NET_BALL_BLACK) != 0) continue;
+        if (ball.y / 32.0f < CATCH_HEIGHT) continue;
+        float dx = ball.x / 16.0f - px;
+        float dz = ball.z / 16.0f - pz;
+        float distSq = dx * dx + dz * dz;
+        if (distSq < bestDistSq) {
+            bestDistSq = distSq;
+            tx = dx;
+            tz = dz;
+        }
+    }
+    if (bestDistSq > 1.0e8f || bestDistSq < ARRIVE_RADIUS * ARRIVE_RADIUS) return input;
+
+    float turn = atan2f(tz, tx) * 57.2957795f - player.yaw * 0.01f;
+    while (turn > 180.0f)  turn -= 360.0f;
+    while (turn < -180.0f) turn += 360.0f;
+    turn = max(-MAX_TURN, min(MAX_TURN, turn));
+    input.yawDelta = static_cast<int16_t>(lroundf(turn * 100.0f));
+    if (fabsf(turn) < 45.0f) input.keys = REPLAY_KEY_FORWARD;
+    return input;
+}
+
+static void SendInput(Client& client, const sockaddr_in& server, vector<uint8_t>& datagram,
+                      Random& random, float loss) {
+    for (int k = NET_INPUT_REDUNDANCY - 1; k > 0; --k) {
+        client.inputs[k] = client.inputs[k - 1];
+    }
+    client.inputs[0] = BotInput(client);
+    client.inputs[0].sequence = ++client.sequence;
+
+    NetInputHeader header = {};
+    header.ackTick = client.newest;
+    header.session = client.session;
+    header.count   = static_cast<uint8_t>(min<uint32_t>(client.sequence, NET_INPUT_REDUNDANCY));
+    datagram.clear();
+    StateWriter out(datagram);
+    out.Write(static_cast<uint8_t>(NET_INPUT));
+    out.Write(header);
+    for (int k = 0; k < header.count; ++k) {
+        out.Write(client.inputs[k]);
+    }
+    Send(client, server, datagram, random, loss);
+}
+
+// Ask the server for its counters on a socket of its own
+static bool RequestStats(const sockaddr_in& server, NetServerStats& stats) {
+    UdpSocket socket;
+    if (!socket.Open(0)) return false;
+    uint8_t request = NET_STATS_REQUEST;
+    vector<uint8_t> buffer(NET_MAX_DATAGRAM);
+    for (int attempt = 0; attempt < 5; ++attempt) {
+        socket.Send(server, &request, 1);
+        while (socket.Wait(200)) {
+            sockaddr_in from;
+            int size = socket.Receive(buffer.data(), buffer.size(), &from);
+            StateReader in(buffer.data(), size < 0 ? 0 : size);
+            uint8_t type = 0;
+            if (in.Read(type) && type == NET_STATS && in.Read(stats)) return true;
+        }
+    }
+    return false;
+}
+
+static void AddTraffic(Traffic& total, const Traffic& t) {
+    total.bytesSent         += t.bytesSent;
+    total.bytesReceived     += t.bytesReceived;
+    total.datagramsSent     += t.datagramsSent;
+    total.datagramsReceived += t.datagramsReceived;
+    total.snapshots         += t.snapshots;
+    total.fullSnapshots     += t.fullSnapshots;
+    total.fullBytes         += t.fullBytes;
+    total.deltaBytes        += t.deltaBytes;
+    total.badHashes         += t.badHashes;
+    total.missingBase       += t.missingBase;
+    total.outOfOrder        += t.outOfOrder;
+}
+
+int main(int argc, char** argv) {
+    const char* host = "127.0.0.1";
+    int clientCount = 100;
+    double seconds = 10.0;
+    Difficulty difficulty = HARD;
+    float loss = 0.0f;
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--server") == 0) {
+            host = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--clients") == 0) {
+            clientCount = max(1, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = max(0.1, atof(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--difficulty") == 0) {
+            for (int d = EASY; d <= HARD; ++d) {
+                if (strcmp(argv[i + 1], DIFFICULTY_NAMES[d]) == 0) difficulty = static_cast<Difficulty>(d);
+            }
+        }
+        else if (strcmp(argv[i], "--loss") == 0) {
+            loss = static_cast<float>(max(0.0, min(100.0, atof(argv[i + 1]))));
+        }
+    }
+
+    sockaddr_in server;
+    if (!ResolveAddress(host, NET_DEFAULT_PORT, server)) {
+        fprintf(stderr, "Could not resolve %s\n", host);
+        return 1;
+    }
+
+    vector<unique_ptr<Client>> clients(clientCount);
+    for (int c = 0; c < clientCount; ++c) {
+        clients[c].reset(new Client());
+        Client& client = *clients[c];
+        if (!client.socket.Open(0, 256 << 10)) {
+            fprintf(stderr, "Could not open socket %d (raise ulimit -n for more clients)\n", c);
+            return 1;
+        }
+        client.nonce    = 0x9E3779B9u * (c + 1);
+        client.session  = NET_NO_SESSION;
+        client.accepted = false;
+        client.newest   = NET_NO_TICK;
+        client.sequence = 0;
+        for (uint32_t& tick : client.stateTick) tick = NET_NO_TICK;
+    }
+
+    // Connect everyone, resending CONNECT to those not yet accepted
+    Random random(12345);
+    vector<uint8_t> buffer;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int accepted = 0;
+    while (accepted < clientCount && SecondsSince(start) < CONNECT_TIMEOUT) {
+        for (unique_ptr<Client>& client : clients) {
+            if (!client->accepted) SendConnect(*client, server, difficulty);
+        }
+        this_thread::sleep_for(chrono::milliseconds(100));
+        accepted = 0;
+        for (unique_ptr<Client>& client : clients) {
+            Drain(*client, buffer, random, 0.0f);
+            accepted += client->accepted ? 1 : 0;
+        }
+    }
+    if (accepted < clientCount) {
+        fprintf(stderr, "Only %d of %d clients were accepted\n", accepted, clientCount);
+        if (accepted == 0) return 1;
+    }
+
+    float tickRate = 60.0f;
+    {
+        NetServerStats stats;
+        if (RequestStats(server, stats)) tickRate = stats.tickRate;
+    }
+    printf("%d clients connected in %.2f s, %s, server ticking at %.0f Hz, %.1f%% loss each way\n",
+           accepted, SecondsSince(start), DIFFICULTY_NAMES[difficulty], tickRate, loss);
+    fflush(stdout);
+
+    // Play at the server's tick rate: drain, then send one input each.
+    // The window after WARM_UP is what gets measured.
+    typedef chrono::steady_clock Clock;
+    const Clock::duration interval = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / tickRate));
+    NetServerStats before = {}, after = {};
+    bool measuring = false;
+    bool haveServerStats = true;
+    int lateTicks = 0;
+    Clock::time_point next = Clock::now();
+    Clock::time_point playStart = next;
+    Clock::time_point measureStart = next;
+    for (;;) {
+        double elapsed = chrono::duration<double>(Clock::now() - playStart).count();
+        if (!measuring && elapsed >= WARM_UP) {
+            haveServerStats = RequestStats(server, before);
+            for (unique_ptr<Client>& client : clients) client->traffic = Traffic();
+            measuring = true;
+            measureStart = Clock::now();
+        }
+        if (measuring && chrono::duration<double>(Clock::now() - measureStart).count() >= seconds) break;
+
+        for (unique_ptr<Client>& client : clients) {
+            Drain(*client, buffer, random, loss);
+            if (client->accepted) SendInput(*client, server, buffer, random, loss);
+        }
+
+        next += interval;
+        if (Clock::now() > next) {
+            ++lateTicks;
+            next = Clock::now();
+        }
+        else {
+            this_thread::sleep_until(next);
+        }
+    }
+    double measured = SecondsSince(measureStart);
+    haveServerStats = RequestStats(server, after) && haveServerStats;
+
+    for (unique_ptr<Client>& client : clients) {
+        if (!client->accepted) continue;
+        vector<uint8_t> datagram;
+        StateWriter out(datagram);
+        out.Write(static_cast<uint8_t>(NET_DISCONNECT));
+        out.Write(client->session);
+        client->socket.Send(server, datagram.data(), datagram.size());
+    }
+
+    Traffic total = {};
+    for (unique_ptr<Client>& client : clients) {
+        if (client->accepted) AddTraffic(total, client->traffic);
+    }
+    const double perClient = 1.0 / (accepted * measured);
+    uint64_t deltas = total.snapshots - total.fullSnapshots;
+    printf("snapshots   %llu decoded (%.1f/s per client), %llu full, %llu bad hashes, "
+           "%llu without base, %llu out of order\n",
+           (unsigned long long)total.snapshots, total.snapshots * perClient,
+           (unsigned long long)total.fullSnapshots, (unsigned long long)total.badHashes,
+           (unsigned long long)total.missingBase, (unsigned long long)total.outOfOrder);
+    printf("payload     delta %.1f B mean, full %.1f B mean\n",
+           deltas ? double(total.deltaBytes) / deltas : 0.0,
+           total.fullSnapshots ? double(total.fullBytes) / total.fullSnapshots : 0.0);
+
+    // UDP payload, then with the 28 bytes of IPv4 and UDP header per datagram
+    const double headers = 28.0;
+    printf("per client  down %.2f KB/s (%.2f KB/s on the wire), up %.2f KB/s (%.2f KB/s on the wire)\n",
+           total.bytesReceived * perClient / 1024.0,
+           (total.bytesReceived + headers * total.datagramsReceived) * perClient / 1024.0,
+           total.bytesSent * perClient / 1024.0,
+           (total.bytesSent + headers * total.datagramsSent) * perClient / 1024.0);
+
+    if (haveServerStats && after.ticks > before.ticks) {
+        double ticks = double(after.ticks - before.ticks);
+        double sessions = (after.sessionTicks - before.sessionTicks) / ticks;
+        double wall = after.wallSeconds - before.wallSeconds;
+        double cores = wall > 0 ? (after.cpuSeconds - before.cpuSeconds) / wall : 0.0;
+        printf("server      %.1f sessions, %.3f cores busy, %.0f sessions per core at %.0f Hz, "
+               "%llu tick overruns, %u threads\n",
+               sessions, cores, cores > 0 ? sessions / cores : 0.0, after.tickRate,
+               (unsigned long long)(after.overruns - before.overruns), after.threads);
+    }
+    else {
+        printf("server      no stats reply\n");
+    }
+    if (lateTicks > 0) {
+        printf("swarm fell behind the tick rate %d times; inputs were late\n", lateTicks);
+    }
+    return total.badHashes == 0 ? 0 : 1;
+}
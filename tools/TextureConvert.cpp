@@ -0,0 +1,292 @@
+// Offline texture converter: turns a 24- or 32-bit BMP into a DDS file
+// holding the full mip chain, either DXT1 block-compressed or as 32-bit BGRA,
+// so the game uploads ready-made levels instead of decoding at load time.
+//
+//   ballquest_texconv IN.bmp OUT.dds [--format dxt1|bgra]
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../include/DdsFormat.h"
+
+using namespace std;
+
+struct Image {
+    int width;
+    int height;
+    vector<float> pixels;         // Linear RGB, bottom row first
+};
+
+// sRGB <-> linear, so mip levels average light rather than encoded values
+static float ToLinear(int value) {
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static int ToSrgb(float c) {
+    c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+    int value = static_cast<int>(c * 255.0f + 0.5f);
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static bool ReadBitmap(const char* path, Image& image) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    vector<unsigned char> data;
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    fclose(file);
+
+    // BITMAPFILEHEADER (14 bytes) then BITMAPINFOHEADER (40 bytes or more)
+    if (data.size() < 54 || data[0] != 'B' || data[1] != 'M') return false;
+    uint32_t offset, infoSize, compression;
+    int32_t width, height;
+    uint16_t planes, bits;
+    memcpy(&offset, &data[10], 4);
+    memcpy(&infoSize, &data[14], 4);
+    memcpy(&width, &data[18], 4);
+    memcpy(&height, &data[22], 4);
+    memcpy(&planes, &data[26], 2);
+    memcpy(&bits, &data[28], 2);
+    memcpy(&compression, &data[30], 4);
+
+    int rows = height < 0 ? -height : height;
+    int bytesPerPixel = bits / 8;
+    if (infoSize < 40 || planes != 1 || (bits != 24 && bits != 32) ||
+        !(compression == 0 || (compression == 3 && bits == 32)) ||
+        width <= 0 || width > 32768 || rows <= 0 || rows > 32768) {
+        return false;
+    }
+    size_t stride = (static_cast<size_t>(width) * bytesPerPixel + 3) & ~size_t(3);
+    if (offset > data.size() || stride * rows > data.size() - offset) return false;
+
+    float linear[256];
+    for (int i = 0; i < 256; ++i) linear[i] = ToLinear(i);
+
+    image.width = width;
+    image.height = rows;
+    image.pixels.resize(static_cast<size_t>(width) * rows * 3);
+    for (int y = 0; y < rows; ++y) {
+        // Top-down files are flipped so row 0 is always the bottom
+        int fileRow = height > 0 ? y : rows - 1 - y;
+        const unsigned char* src = &data[offset + fileRow * stride];
+        float* dst = &image.pixels[static_cast<size_t>(y) * width * 3];
+        for (int x = 0; x < width; ++x) {
+            dst[x * 3 + 0] = linear[src[x * bytesPerPixel + 2]];
+            dst[x * 3 + 1] = linear[src[x * bytesPerPixel + 1]];
+            dst[x * 3 + 2] = linear[src[x * bytesPerPixel + 0]];
+        }
+    }
+    return true;
+}
+
+// Next level down: each texel averages the 2x2 footprint it covers. At an
+// odd edge the last texel also takes the leftover row or column, so its
+// footprint is 3 wide and nothing in the source is dropped.
+static Image Downsample(const Image& src) {
+    Image dst;
+    dst.width  = src.width  > 1 ? src.width  / 2 : 1;
+    dst.height = src.height > 1 ? src.height / 2 : 1;
+    dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * 3);
+
+    for (int y = 0; y < dst.height; ++y) {
+        int y0 = y * 2;
+        int y1 = y + 1 < dst.height ? y0 + 2 : src.height;
+        for (int x = 0; x < dst.width; ++x) {
+            int x0 = x * 2;
+            int x1 = x + 1 < dst.width ? x0 + 2 : src.width;
+            float sum[3] = { 0, 0, 0 };
+            for (int sy = y0; sy < y1; ++sy) {
+                const float* row = &src.pixels[static_cast<size_t>(sy) * src.width * 3];
+                for (int sx = x0; sx < x1; ++sx) {
+                    sum[0] += row[sx * 3 + 0];
+                    sum[1] += row[sx * 3 + 1];
+                    sum[2] += row[sx * 3 + 2];
+                }
+            }
+            float scale = 1.0f / ((y1 - y0) * (x1 - x0));
+            float* out = &dst.pixels[(static_cast<size_t>(y) * dst.width + x) * 3];
+            out[0] = sum[0] * scale;
+            out[1] = sum[1] * scale;
+            out[2] = sum[2] * scale;
+        }
+    }
+    return dst;
+}
+
+static void EncodeBgra(const Image& image, vector<unsigned char>& out) {
+    for (size_t i = 0; i < image.pixels.size(); i += 3) {
+        out.push_back(static_cast<unsigned char>(ToSrgb(image.pixels[i + 2])));
+        out.push_back(static_cast<unsigned char>(ToSrgb(image.pixels[i + 1])));
+        out.push_back(static_cast<unsigned char>(ToSrgb(image.pixels[i + 0])));
+        out.push_back(255);
+    }
+}
+
+static uint16_t Pack565(const int* rgb) {
+    return static_cast<uint16_t>(((rgb[0] * 31 + 127) / 255) << 11 |
+                                 ((rgb[1] * 63 + 127) / 255) << 5 |
+                                 ((rgb[2] * 31 + 127) / 255));
+}
+
+static void Unpack565(uint16_t color, int* rgb) {
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// One 4x4 block: endpoints on the bounding-box diagonal that follows the
+// colors' spread, inset a little, and each texel takes the nearest of the
+// four palette entries
+static void EncodeDxt1Block(const int block[16][3], unsigned char* out) {
+    int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            lo[c] = block[i][c] < lo[c] ? block[i][c] : lo[c];
+            hi[c] = block[i][c] > hi[c] ? block[i][c] : hi[c];
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+
+    // Flip red and blue across the box when they run against green
+    float covRG = 0, covBG = 0;
+    for (int i = 0; i < 16; ++i) {
+        float g = block[i][1] - mean[1];
+        covRG += (block[i][0] - mean[0]) * g;
+        covBG += (block[i][2] - mean[2]) * g;
+    }
+    if (covRG < 0) { int t = lo[0]; lo[0] = hi[0]; hi[0] = t; }
+    if (covBG < 0) { int t = lo[2]; lo[2] = hi[2]; hi[2] = t; }
+
+    for (int c = 0; c < 3; ++c) {
+        int inset = (hi[c] - lo[c]) / 16;
+        hi[c] -= inset;
+        lo[c] += inset;
+    }
+
+    uint16_t c0 = Pack565(hi), c1 = Pack565(lo);
+    uint32_t indices = 0;
+    if (c0 < c1) { uint16_t t = c0; c0 = c1; c1 = t; }
+    if (c0 != c1) {
+        // c0 > c1 selects the four-color mode
+        int palette[4][3];
+        Unpack565(c0, palette[0]);
+        Unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int dr = block[i][0] - palette[p][0];
+                int dg = block[i][1] - palette[p][1];
+                int db = block[i][2] - palette[p][2];
+                int error = dr * dr + dg * dg + db * db;
+                if (error < bestError) { bestError = error; best = p; }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+
+    memcpy(out, &c0, 2);
+    memcpy(out + 2, &c1, 2);
+    memcpy(out + 4, &indices, 4);
+}
+
+static void EncodeDxt1(const Image& image, vector<unsigned char>& out) {
+    for (int by = 0; by < image.height; by += 4) {
+        for (int bx = 0; bx < image.width; bx += 4) {
+            // Blocks past the edge repeat the last row/column
+            int block[16][3];
+            for (int i = 0; i < 16; ++i) {
+                int x = bx + i % 4, y = by + i / 4;
+                x = x < image.width ? x : image.width - 1;
+                y = y < image.height ? y : image.height - 1;
+                const float* p = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 3];
+                for (int c = 0; c < 3; ++c) block[i][c] = ToSrgb(p[c]);
+            }
+            unsigned char encoded[8];
+            EncodeDxt1Block(block, encoded);
+            out.insert(out.end(), encoded, encoded + 8);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s IN.bmp OUT.dds [--format dxt1|bgra]\n", argv[0]);
+        return 2;
+    }
+
+    bool dxt1 = true;
+    for (int i = 3; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--format") == 0) {
+            if (strcmp(argv[i + 1], "bgra") == 0) dxt1 = false;
+            else if (strcmp(argv[i + 1], "dxt1") != 0) {
+                fprintf(stderr, "unknown format %s\n", argv[i + 1]);
+                return 2;
+            }
+        }
+    }
+
+    Image level;
+    if (!ReadBitmap(argv[1], level)) {
+        fprintf(stderr, "%s: not an uncompressed 24/32-bit bitmap\n", argv[1]);
+        return 1;
+    }
+
+    DdsHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = sizeof(DdsHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+                   (dxt1 ? DDSD_LINEARSIZE : DDSD_PITCH);
+    header.width = level.width;
+    header.height = level.height;
+    header.pitchOrLinearSize = dxt1 ? DdsLevelSize(true, level.width, level.height) : level.width * 4;
+    header.mipMapCount = DdsMipCount(level.width, level.height);
+    header.format.size = sizeof(DdsPixelFormat);
+    if (dxt1) {
+        header.format.flags = DDPF_FOURCC;
+        header.format.fourCC = DDS_FOURCC_DXT1;
+    }
+    else {
+        header.format.flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+        header.format.rgbBitCount = 32;
+        header.format.rMask = 0x00FF0000;
+        header.format.gMask = 0x0000FF00;
+        header.format.bMask = 0x000000FF;
+        header.format.aMask = 0xFF000000;
+    }
+    header.caps = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    vector<unsigned char> body;
+    for (uint32_t i = 0; i < header.mipMapCount; ++i) {
+        if (i > 0) level = Downsample(level);
+        if (dxt1) EncodeDxt1(level, body);
+        else EncodeBgra(level, body);
+    }
+
+    FILE* file = fopen(argv[2], "wb");
+    if (!file) {
+        fprintf(stderr, "%s: cannot write\n", argv[2]);
+        return 1;
+    }
+    bool ok = fwrite(&DDS_MAGIC, 4, 1, file) == 1 &&
+              fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(body.data(), 1, body.size(), file) == body.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %ux%u, %u levels, %s, %zu bytes\n", argv[2], header.width, header.height,
+           header.mipMapCount, dxt1 ? "DXT1" : "BGRA8", body.size() + 4 + sizeof(header));
+    return 0;
+}
@@ -0,0 +1,278 @@
+// Bot tournament for difficulty tuning: plays many headless games per
+// difficulty with scripted bots, spread over every core, and prints the
+// score and survival distributions of each bot at each difficulty.
+//
+//   ballquest_tournament [--games N] [--threads N] [--seed S]
+//                        [--bot idle|chaser|dodger|all]
+//                        [--difficulty easy|medium|hard|all] [--csv FILE]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../include/GameWorld.h"
+#include "../include/JobSystem.h"
+#include "../include/Profiler.h"
+
+using namespace std;
+
+// Player limits the bots keep to, like a person with a mouse
+const float MAX_TURN      = 6.0f;                      // Degrees per step
+const float WALK_SPEED    = 0.1f / SIM_STEP;           // Units per second at the default camera speed
+const float CATCH_HEIGHT  = 4.0f;                      // Top of the catch cylinder at standing height
+const float ARRIVE_RADIUS = 0.3f;                      // Close enough to stop under a ball
+const float DANGER_RADIUS = 1.5f;                      // Black balls landing this close are avoided
+const float DANGER_TIME   = 1.0f;                      // Seconds of warning before they get there
+
+enum Bot {
+    BOT_IDLE,      // Stands at the start; the floor for every other bot
+    BOT_CHASER,    // Runs under the reachable regular ball that drops first
+    BOT_DODGER,    // Chaser that skips targets near black balls and steps away from them
+    BOT_COUNT
+};
+
+static const char* const BOT_NAMES[BOT_COUNT] = { "idle", "chaser", "dodger" };
+static const char* const DIFFICULTY_NAMES[3]  = { "easy", "medium", "hard" };
+
+struct GameResult {
+    int   score;
+    int   lifeLeft;
+    int   blackHits;
+    float survivedSeconds;
+    bool  survived;        // Still alive when the clock ran out
+};
+
+// Seconds until a ball falls to catch height, or a large value if it
+// already has
+static float TimeToCatchHeight(const FruitPool& fruits, int index, float multiplier) {
+    float drop = fruits.Y()[index] - CATCH_HEIGHT;
+    if (drop < 0.0f) return 1.0e9f;
+    return drop / (fruits.Speed()[index] * multiplier);
+}
+
+// True if a black ball will come down within DANGER_RADIUS of (x, z) in
+// the next DANGER_TIME seconds; away points from the nearest one to (x, z)
+static bool BlackBallNear(const GameWorld& world, float x, float z, float* awayX, float* awayZ) {
+    const FruitPool& black = world.GetBlackFruits();
+    float nearest = DANGER_RADIUS * DANGER_RADIUS;
+    bool found = false;
+    for (int i = 0; i < black.Size(); ++i) {
+        if (!black.IsActive(i)) continue;
+        if (TimeToCatchHeight(black, i, world.GetFruitSpeedMultiplier()) > DANGER_TIME) continue;
+        float dx = x - black.X()[i];
+        float dz = z - black.Z()[i];
+        float distSq = dx * dx + dz * dz;
+        if (distSq < nearest) {
+            nearest = distSq;
+            found = true;
+            if (awayX) *awayX = dx;
+            if (awayZ) *awayZ = dz;
+        }
+    }
+    return found;
+}
+
+// Pick the regular ball the bot can get under first, or -1
+static int ChooseTarget(const GameWorld& world, bool avoidBlack) {
+    const FruitPool& main = world.GetMainFruits();
+    const Vector3& position = world.GetPosition();
+    float multiplier = world.GetFruitSpeedMultiplier();
+
+    int best = -1;
+    float bestTime = 1.0e9f;
+    for (int i = 0; i < main.Size(); ++i) {
+        if (!main.IsActive(i)) continue;
+        float dx = main.X()[i] - position.x;
+        float dz = main.Z()[i] - position.z;
+        float walk = sqrtf(dx * dx + dz * dz) / WALK_SPEED;
+        float fall = TimeToCatchHeight(main, i, multiplier);
+        if (walk > fall || fall >= bestTime) continue;
+        if (avoidBlack && BlackBallNear(world, main.X()[i], main.Z()[i], nullptr, nullptr)) continue;
+        best = i;
+        bestTime = fall;
+    }
+    return best;
+}
+
+// Turn toward (dx, dz) at most MAX_TURN degrees and walk there
+static void SteerToward(const GameWorld& world, float dx, float dz, GameInput& input) {
+    Vector3 facing = world.GetView() - world.GetPosition();
+    float currentYaw = atan2f(facing.z, facing.x) * 57.2957795f;
+    float targetYaw  = atan2f(dz, dx) * 57.2957795f;
+    float turn = targetYaw - currentYaw;
+    while (turn > 180.0f)  turn -= 360.0f;
+    while (turn < -180.0f) turn += 360.0f;
+    input.yawDelta = max(-MAX_TURN, min(MAX_TURN, turn));
+
+    // Walk only once roughly facing the way, so turning doesn't wander
+    input.forward = fabsf(turn) < 45.0f;
+}
+
+static GameInput BotInput(Bot bot, const GameWorld& world) {
+    GameInput input;
+    if (bot == BOT_IDLE) return input;
+
+    const Vector3& position = world.GetPosition();
+    float awayX = 0.0f, awayZ = 0.0f;
+    if (bot == BOT_DODGER && BlackBallNear(world, position.x, position.z, &awayX, &awayZ)) {
+        if (awayX == 0.0f && awayZ == 0.0f) awayX = 1.0f;
+        SteerToward(world, awayX, awayZ, input);
+        input.forward = true;
+        input.sprint  = true;
+        return input;
+    }
+
+    int target = ChooseTarget(world, bot == BOT_DODGER);
+    if (target < 0) return input;
+    const FruitPool& main = world.GetMainFruits();
+    float dx = main.X()[target] - position.x;
+    float dz = main.Z()[target] - position.z;
+    if (dx * dx + dz * dz < ARRIVE_RADIUS * ARRIVE_RADIUS) return input;
+    SteerToward(world, dx, dz, input);
+    return input;
+}
+
+static GameResult PlayGame(GameWorld& world, Bot bot, Difficulty difficulty, uint32_t seed) {
+    world.SetSeed(seed);
+    world.Start(difficulty);
+    int startLife = world.GetLife();
+
+    while (!world.IsOver()) {
+        world.Step(SIM_STEP, BotInput(bot, world));
+    }
+
+    GameResult result;
+    result.score           = world.GetScore();
+    result.lifeLeft        = world.GetLife();
+    result.blackHits       = startLife - world.GetLife();
+    result.survivedSeconds = min(world.GetGameTime(), GAME_DURATION);
+    result.survived        = world.GetLife() > 0;
+    return result;
+}
+
+static void PrintSummary(Bot bot, Difficulty difficulty, const GameResult* results, int count) {
+    vector<float> scores(count), seconds(count);
+    double scoreSum = 0.0, secondSum = 0.0, hitSum = 0.0;
+    int survivors = 0;
+    for (int g = 0; g < count; ++g) {
+        scores[g]  = static_cast<float>(results[g].score);
+        seconds[g] = results[g].survivedSeconds;
+        scoreSum  += results[g].score;
+        secondSum += results[g].survivedSeconds;
+        hitSum    += results[g].blackHits;
+        survivors += results[g].survived ? 1 : 0;
+    }
+    sort(scores.begin(), scores.end());
+    sort(seconds.begin(), seconds.end());
+
+    printf("%-7s %-7s %7.1f %6.0f %6.0f %6.0f %6.0f %7.1f%% %8.1f %8.1f %6.2f\n",
+           BOT_NAMES[bot], DIFFICULTY_NAMES[difficulty],
+           scoreSum / count, Percentile(scores, 0.1f), Percentile(scores, 0.5f),
+           Percentile(scores, 0.9f), scores.back(),
+           100.0 * survivors / count, secondSum / count, Percentile(seconds, 0.5f),
+           hitSum / count);
+}
+
+static int ParseChoice(const char* value, const char* const* names, int count) {
+    if (strcmp(value, "all") == 0) return -1;
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(value, names[i]) == 0) return i;
+    }
+    fprintf(stderr, "unknown choice %s\n", value);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int gamesPer = 200;
+    int threadCount = 0;
+    uint32_t baseSeed = 1;
+    int onlyBot = -1;
+    int onlyDifficulty = -1;
+    const char* csvPath = nullptr;
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "--games") == 0) {
+            gamesPer = max(1, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            baseSeed = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--bot") == 0) {
+            onlyBot = ParseChoice(argv[i + 1], BOT_NAMES, BOT_COUNT);
+        }
+        else if (strcmp(argv[i], "--difficulty") == 0) {
+            onlyDifficulty = ParseChoice(argv[i + 1], DIFFICULTY_NAMES, 3);
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            csvPath = argv[i + 1];
+        }
+    }
+
+    // Every (bot, difficulty) pairing plays the same gamesPer seeds, so
+    // bots are compared on identical ball sequences
+    struct Match {
+        Bot        bot;
+        Difficulty difficulty;
+    };
+    vector<Match> matches;
+    for (int bot = 0; bot < BOT_COUNT; ++bot) {
+        if (onlyBot >= 0 && bot != onlyBot) continue;
+        for (int diff = EASY; diff <= HARD; ++diff) {
+            if (onlyDifficulty >= 0 && diff != onlyDifficulty) continue;
+            matches.push_back({ static_cast<Bot>(bot), static_cast<Difficulty>(diff) });
+        }
+    }
+
+    const int total = static_cast<int>(matches.size()) * gamesPer;
+    vector<GameResult> results(total);
+    JobSystem jobs(threadCount);
+    printf("%d games (%d per bot and difficulty) on %d threads\n", total, gamesPer, jobs.ThreadCount());
+
+    // One world per chunk, reused for its games; each world runs
+    // single-threaded, the games are what runs in parallel
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    auto body = [&](int begin, int end) {
+        GameWorld world;
+        SpawnSchedule hard = DefaultSpawnSchedule(HARD);
+        world.ReserveFruits(hard.mainPeak, hard.blackPeak);
+        for (int g = begin; g < end; ++g) {
+            const Match& match = matches[g / gamesPer];
+            results[g] = PlayGame(world, match.bot, match.difficulty, baseSeed + g % gamesPer);
+        }
+    };
+    jobs.ParallelFor(total, 1, body);
+    double elapsed = SecondsSince(start);
+
+    double simulated = 0.0;
+    for (const GameResult& result : results) simulated += result.survivedSeconds;
+
+    printf("%-7s %-7s %7s %6s %6s %6s %6s %8s %8s %8s %6s\n",
+           "bot", "level", "score", "p10", "p50", "p90", "max", "survive", "mean s", "p50 s", "hits");
+    for (size_t m = 0; m < matches.size(); ++m) {
+        PrintSummary(matches[m].bot, matches[m].difficulty, &results[m * gamesPer], gamesPer);
+    }
+    printf("%.2f s wall, %.1f games/s, %.0fx real time\n",
+           elapsed, total / elapsed, simulated / elapsed);
+
+    if (csvPath) {
+        FILE* file = fopen(csvPath, "w");
+        if (!file) {
+            fprintf(stderr, "Could not write %s\n", csvPath);
+            return 1;
+        }
+        fprintf(file, "bot,difficulty,seed,score,life_left,black_hits,seconds,survived\n");
+        for (int g = 0; g < total; ++g) {
+            const Match& match = matches[g / gamesPer];
+            const GameResult& r = results[g];
+            fprintf(file, "%s,%s,%u,%d,%d,%d,%.3f,%d\n",
+                    BOT_NAMES[match.bot], DIFFICULTY_NAMES[match.difficulty], baseSeed + g % gamesPer,
+                    r.score, r.lifeLeft, r.blackHits, r.survivedSeconds, r.survived ? 1 : 0);
+        }
+        fclose(file);
+    }
+    return 0;
+}